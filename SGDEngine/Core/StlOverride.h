@@ -2,6 +2,8 @@
 
 #include <memory>
 #include <atomic>
+#include <utility>
+#include <type_traits>
 
 namespace SGD
 {
@@ -37,10 +39,23 @@ namespace SGD
 	}
 #endif
 
+	template<class T>
+	void swap(T& a, T& b)
+	{
+		std::swap(a, b);
+	}
+
 	// atomic
 	template <class Type>
 	using atomic = std::atomic<Type>;
 
+	// type traits
+	template <class Type>
+	using is_trivially_destructible = std::is_trivially_destructible<Type>;
+
+	template <class Type>
+	using is_trivially_copyable = std::is_trivially_copyable<Type>;
+
 	// numeric limits
 	template <class Type>
 	using numeric_limits = std::numeric_limits<Type>;
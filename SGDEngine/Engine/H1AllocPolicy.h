@@ -45,16 +45,38 @@ namespace Memory
 
 	/*
 		- default alloc page policy using MemoryArena
-		- 64KB page allocation
+		- page allocation (PageSizeParam: power of two in [4KB, 1MB], 64KB by default)
+			- small-block pools prefer smaller pages for locality, large-object pools prefer bigger pages for less refill
 		- 2MB chunk allocation
+		- each chunk counts its live pages, the chunk whose pages are all free is returned to MemoryArena (except for MaxEmptyChunkCount chunks)
+			- the release is deferred while any page pop is in flight, next Allocate or Deallocate retries it
 	*/
+	template <int32 PageSizeParam = 64 * 1024>
 	class H1DefaultAllocPagePolicy : public H1AllocPagePolicy
 	{
 	public:
+		enum
+		{
+			DEFAULT_MAX_EMPTY_CHUNK_COUNT = 1,
+			MIN_PAGE_SIZE = 4 * 1024,
+			MAX_PAGE_SIZE = 1024 * 1024,
+		};
+
 		H1DefaultAllocPagePolicy()
 			: H1AllocPagePolicy()
+			, ChunkHead(nullptr)
+			, ChunkCount(0)
+			, PendingChunkHead(nullptr)
+			, PendingChunkCount(0)
+			, InFlightPopCount(0)
+			, EmptyChunkCount(0)
+			, MaxEmptyChunkCount(DEFAULT_MAX_EMPTY_CHUNK_COUNT)
+			, ReclaimedChunkCount(0)
 		{
-
+			// the page size should be power of two in [MIN_PAGE_SIZE, MAX_PAGE_SIZE], so a chunk (memory block) is divided into pages without remainder
+			SGD_CT_ASSERT((PageSizeParam & (PageSizeParam - 1)) == 0);
+			SGD_CT_ASSERT(PageSizeParam >= MIN_PAGE_SIZE && PageSizeParam <= MAX_PAGE_SIZE);
+			SGD_CT_ASSERT(H1MemoryArena::MEMORY_BLOCK_SIZE % PageSizeParam == 0);
 		}
 
 		virtual ~H1DefaultAllocPagePolicy()
@@ -62,14 +84,18 @@ namespace Memory
 			DestroyAllChunks();
 		}
 
+		// inner forward declaration
+		class H1AllocChunk;
+
 		// H1AllocPage definition
 		class H1AllocPage : public SGD::Container::SinglelyLinkedList::H1Node
 		{
 		public:
 			enum
 			{
-				HeaderSize = sizeof(SGD::Container::SinglelyLinkedList::H1Node),
-				DataSize = (64 * 1024) - HeaderSize,	// 64KB page allocation (excluding HeaderSize)
+				// node and owner chunk
+				HeaderSize = sizeof(SGD::Container::SinglelyLinkedList::H1Node) + sizeof(H1AllocChunk*),
+				DataSize = PageSizeParam - HeaderSize,	// page allocation (excluding HeaderSize)
 				PageSize = HeaderSize + DataSize,
 			};			
 
@@ -77,7 +103,7 @@ namespace Memory
 			virtual ~H1AllocPage() {}
 
 			// public methods
-			H1AllocPage* GetNext() { return Next; }
+			H1AllocPage* GetNext() { return static_cast<H1AllocPage*>(Next); }
 			void SetNext(H1AllocPage* InNext) { Next = InNext; }
 
 			int64 GetSize() { return (int64)DataSize; }
@@ -85,36 +111,91 @@ namespace Memory
 
 		protected:
 			friend class H1DefaultAllocPagePolicy;
+
+			// the chunk which the page is carved from (it is kept while the page is allocated)
+			H1AllocChunk* OwnerChunk;
 		};
 
 		H1AllocPage* Allocate() 
 		{
-			// if there is no valid node exists, create new chunk!
-			if (FreeHead.GetNode() == nullptr)
+			// the free list can be emptied by other threads (allocation or reclamation) after the check, so retry until a page is popped
+			H1AllocPage* NewPage = nullptr;
+			while (NewPage == nullptr)
 			{
-				CreateNewChunk();
+				// if there is no valid node exists, create new chunk!
+				if (FreeHead.GetNode() == nullptr)
+				{
+					CreateNewChunk();
+				}
+
+				// pop the new page from the free head
+				//	- the pop reads the next link of the head page, so reclamation defers releasing chunks while pops are in flight
+				InFlightPopCount.fetch_add(1);
+				SGD::Container::SinglelyLinkedList::H1Node* NewNode = SGD::Thread::LockFreeStack::TryPop(FreeHead);
+				InFlightPopCount.fetch_sub(1);
+
+				NewPage = static_cast<H1AllocPage*>(NewNode);
 			}
 
-			// pop the new page from the free head
-			SGD::Container::SinglelyLinkedList::H1Node* NewNode = SGD::Thread::LockFreeStack::Pop(FreeHead);
-			H1AllocPage* NewPage = static_cast<H1AllocPage*>(NewNode);
+			// retry releasing the chunks which were pending at the last reclamation
+			TryReleasePendingChunks();
+
+			// the chunk is not empty anymore
+			if (NewPage->OwnerChunk->LivePageCount.fetch_add(1) == 0)
+			{
+				EmptyChunkCount.fetch_sub(1);
+			}
 
 			return NewPage;
 		}
 
 		void Deallocate(H1AllocPage* InAllocPage)
 		{
+			// decrement live page count before pushing the page
+			//	- reclamation only releases the chunk whose pages are all in the free list, so the chunk should not be touched after the push
+			bool bChunkEmpty = (InAllocPage->OwnerChunk->LivePageCount.fetch_sub(1) == 1);
+
 			SGD::Thread::LockFreeStack::Push(FreeHead, InAllocPage);
+
+			if (bChunkEmpty)
+			{
+				// the chunk becomes empty, reclaim when there are more empty chunks than the policy allows
+				//	- skip when other thread is creating or reclaiming chunks, it is reclaimed later
+				if (EmptyChunkCount.fetch_add(1) + 1 > MaxEmptyChunkCount.load() && ChunkSyncObject.TryLock())
+				{
+					ReclaimEmptyChunksInternal();
+					ChunkSyncObject.UnLock();
+					return;
+				}
+			}
+
+			TryReleasePendingChunks();
 		}
 
-	protected:
-		// managing page (MT supported)
-		SGD::Thread::LockFreeStack::H1LfsHead FreeHead;
+		// empty chunks retained for next allocations (not returned to MemoryArena)
+		void SetMaxEmptyChunkCount(int32 InMaxEmptyChunkCount) { MaxEmptyChunkCount.store(InMaxEmptyChunkCount); }
+
+		// return empty chunks over MaxEmptyChunkCount to MemoryArena
+		void ReclaimEmptyChunks()
+		{
+			SGD::Thread::H1ScopeLock Lock(&ChunkSyncObject);
+			ReclaimEmptyChunksInternal();
+		}
+
+		// statistics
+		int32 GetChunkCount() const { return ChunkCount; }
+		int32 GetEmptyChunkCount() const { return EmptyChunkCount.load(); }
+		int64 GetReclaimedChunkCount() const { return ReclaimedChunkCount; }
 
 		// using memory arena, manage the chunk which gives number of pages
 		class H1AllocChunk : public SGD::Container::SinglelyLinkedList::H1Node
 		{
 		public:
+			enum
+			{
+				PageCount = H1MemoryArena::MEMORY_BLOCK_SIZE / H1AllocPage::PageSize,
+			};
+
 			static H1AllocChunk* CreateChunk()
 			{
 				return new H1AllocChunk();
@@ -134,21 +215,45 @@ namespace Memory
 
 			H1AllocChunk()
 				: SGD::Container::SinglelyLinkedList::H1Node()
+				, Prev(nullptr)
+				, LivePageCount(0)
+				, ReclaimFreePageCount(0)
 				, MemoryBlock(H1GlobalSingleton::MemoryArena()->AllocateMemoryBlock())
 			{
 
 			}		
 
+			// chunk list is doubly linked to unlink the reclaimed chunk
+			H1AllocChunk* Prev;
+
+			// allocated pages from this chunk
+			SGD::atomic<int32> LivePageCount;
+			// free pages counted during reclamation (only touched under ChunkSyncObject)
+			int32 ReclaimFreePageCount;
+
 		private:
 			SGD::Memory::H1MemoryBlock MemoryBlock;
 		};
 
+	protected:
+		// managing page (MT supported)
+		SGD::Thread::LockFreeStack::H1LfsHead FreeHead;
+
 		void CreateNewChunk()
 		{
+			SGD::Thread::H1ScopeLock Lock(&ChunkSyncObject);
+
+			// other thread already created new chunk
+			if (FreeHead.GetNode() != nullptr)
+			{
+				return;
+			}
+
 			H1AllocChunk* NewChunk = H1AllocChunk::CreateChunk();
 
-			// link new chunk in lock-free
-			SGD::Thread::LockFreeStack::Push(ChunkHead, NewChunk);
+			// link new chunk (it is empty until its first page is allocated)
+			LinkChunk(NewChunk);
+			EmptyChunkCount.fetch_add(1);
 
 			// generate free pages based on ChunkHead
 			H1AllocChunk* NewHead = NewChunk;
@@ -164,6 +269,7 @@ namespace Memory
 
 				// link the pages
 				CurrPage->SetNext(NewFreePages);
+				CurrPage->OwnerChunk = NewChunk;
 				NewFreePages = CurrPage;
 
 				CurrAddress += H1AllocPage::PageSize;
@@ -173,20 +279,197 @@ namespace Memory
 			SGD::Thread::LockFreeStack::Push(FreeHead, NewFreePages, FreePageTail);
 		}
 
+		void LinkChunk(H1AllocChunk* InChunk)
+		{
+			InChunk->Prev = nullptr;
+			InChunk->Next = ChunkHead;
+			if (ChunkHead != nullptr)
+			{
+				ChunkHead->Prev = InChunk;
+			}
+			ChunkHead = InChunk;
+			ChunkCount++;
+		}
+
+		void UnlinkChunk(H1AllocChunk* InChunk)
+		{
+			H1AllocChunk* NextChunk = (H1AllocChunk*)InChunk->Next;
+			if (InChunk->Prev != nullptr)
+			{
+				InChunk->Prev->Next = NextChunk;
+			}
+			else
+			{
+				ChunkHead = NextChunk;
+			}
+
+			if (NextChunk != nullptr)
+			{
+				NextChunk->Prev = InChunk->Prev;
+			}
+			ChunkCount--;
+		}
+
+		// this method should be called under ChunkSyncObject
+		void ReclaimEmptyChunksInternal()
+		{
+			// take all free pages, so nobody can allocate the pages of the chunk being reclaimed
+			H1AllocPage* FreePages = static_cast<H1AllocPage*>(SGD::Thread::LockFreeStack::PopAll(FreeHead));
+
+			// count free pages for each chunk
+			for (H1AllocPage* CurrPage = FreePages; CurrPage != nullptr; CurrPage = CurrPage->GetNext())
+			{
+				CurrPage->OwnerChunk->ReclaimFreePageCount++;
+			}
+
+			// chunks whose pages are all taken are empty (live page count can be stale here, it is only a trigger)
+			int32 RetainCount = MaxEmptyChunkCount.load();
+			H1AllocChunk* ChunksToRemove = nullptr;
+			H1AllocChunk* CurrChunk = ChunkHead;
+			while (CurrChunk != nullptr)
+			{
+				H1AllocChunk* NextChunk = (H1AllocChunk*)CurrChunk->Next;
+
+				if (CurrChunk->ReclaimFreePageCount == H1AllocChunk::PageCount)
+				{
+					if (RetainCount > 0)
+					{
+						// retain the empty chunk
+						RetainCount--;
+						CurrChunk->ReclaimFreePageCount = 0;
+					}
+					else
+					{
+						UnlinkChunk(CurrChunk);
+						CurrChunk->Next = ChunksToRemove;
+						ChunksToRemove = CurrChunk;
+						EmptyChunkCount.fetch_sub(1);
+					}
+				}
+				else
+				{
+					CurrChunk->ReclaimFreePageCount = 0;
+				}
+
+				CurrChunk = NextChunk;
+			}
+
+			// push back the free pages except for the pages of removed chunks (marked by ReclaimFreePageCount)
+			H1AllocPage* NewFreePages = nullptr;
+			H1AllocPage* FreePageTail = nullptr;
+			H1AllocPage* CurrPage = FreePages;
+			while (CurrPage != nullptr)
+			{
+				H1AllocPage* NextPage = CurrPage->GetNext();
+
+				if (CurrPage->OwnerChunk->ReclaimFreePageCount == 0)
+				{
+					CurrPage->SetNext(NewFreePages);
+					NewFreePages = CurrPage;
+					if (FreePageTail == nullptr)
+					{
+						FreePageTail = CurrPage;
+					}
+				}
+
+				CurrPage = NextPage;
+			}
+
+			if (NewFreePages != nullptr)
+			{
+				SGD::Thread::LockFreeStack::Push(FreeHead, NewFreePages, FreePageTail);
+			}
+
+			// removed chunks are pending until no pop is in flight
+			//	- the pop which started before PopAll can still read the next link of the page in removed chunks
+			while (ChunksToRemove != nullptr)
+			{
+				H1AllocChunk* ChunkToRemove = ChunksToRemove;
+				ChunksToRemove = (H1AllocChunk*)ChunksToRemove->Next;
+
+				ChunkToRemove->Next = PendingChunkHead;
+				PendingChunkHead = ChunkToRemove;
+				PendingChunkCount.fetch_add(1);
+			}
+
+			// the pops starting after PopAll can't reach removed chunks, so no pop in flight means pending chunks are safe to release
+			if (InFlightPopCount.load() == 0)
+			{
+				ReleasePendingChunks();
+			}
+		}
+
+		// this method should be called under ChunkSyncObject (or in synchronized env.)
+		void ReleasePendingChunks()
+		{
+			// return removed chunks to MemoryArena
+			while (PendingChunkHead != nullptr)
+			{
+				H1AllocChunk* ChunkToRemove = PendingChunkHead;
+				PendingChunkHead = (H1AllocChunk*)PendingChunkHead->Next;
+
+				delete ChunkToRemove;
+				ReclaimedChunkCount++;
+			}
+			PendingChunkCount.store(0);
+		}
+
+		// release pending chunks when the pops in flight at the last reclamation are done
+		//	- called by Allocate and Deallocate, so the chunks don't wait for next reclamation (which may never come)
+		//	- skip when other thread holds ChunkSyncObject, the next call retries
+		void TryReleasePendingChunks()
+		{
+			if (PendingChunkCount.load() == 0 || InFlightPopCount.load() != 0)
+			{
+				return;
+			}
+
+			if (ChunkSyncObject.TryLock())
+			{
+				if (InFlightPopCount.load() == 0)
+				{
+					ReleasePendingChunks();
+				}
+				ChunkSyncObject.UnLock();
+			}
+		}
+
 		void DestroyAllChunks()
 		{
 			// this method should be called in synchronized env.
-			H1AllocChunk* CurrChunk = (H1AllocChunk*)ChunkHead.GetNode();
+			H1AllocChunk* CurrChunk = ChunkHead;
 			while (CurrChunk != nullptr)
 			{
 				H1AllocChunk* ChunkToRemove = CurrChunk;
 				CurrChunk = (H1AllocChunk*)CurrChunk->Next;
 				delete ChunkToRemove;
 			}
+
+			ChunkHead = nullptr;
+			ChunkCount = 0;
+
+			ReleasePendingChunks();
 		}
 
-		// managing chunk
-		SGD::Thread::LockFreeStack::H1LfsHead ChunkHead;
+		// managing chunk (synchronized by ChunkSyncObject)
+		SGD::Thread::H1CriticalSection ChunkSyncObject;
+		H1AllocChunk* ChunkHead;
+		int32 ChunkCount;
+
+		// reclaimed chunks waiting for in-flight pops (synchronized by ChunkSyncObject)
+		H1AllocChunk* PendingChunkHead;
+		// count of pending chunks (read without the lock, to skip TryReleasePendingChunks cheaply)
+		SGD::atomic<int32> PendingChunkCount;
+		// pops which can read the page of the chunk being reclaimed
+		SGD::atomic<int32> InFlightPopCount;
+
+		// chunks whose live page count is zero
+		SGD::atomic<int32> EmptyChunkCount;
+		// read by Deallocate without the lock
+		SGD::atomic<int32> MaxEmptyChunkCount;
+
+		// statistics
+		int64 ReclaimedChunkCount;
 	};
 
 	/*
@@ -239,7 +522,7 @@ namespace Memory
 		{
 			SGD::Thread::H1ScopeLock Lock(&SyncObject);
 
-			h1Check(LargeAllocPage != nullptr, "already large memory page is allocated!");
+			h1Check(LargeAllocPage == nullptr, "already large memory page is allocated!");
 			LargeAllocPage =  SGD::make_unique<H1AllocPage>(Size);
 			return LargeAllocPage.get();
 		}
@@ -253,17 +536,17 @@ namespace Memory
 		// only one large page is supported, so do the lock
 		SGD::Thread::H1CriticalSection SyncObject;
 
-		SGD::unqiue_ptr<H1AllocPage> LargeAllocPage;
+		SGD::unique_ptr<H1AllocPage> LargeAllocPage;
 		uint64 Size;
 	};
 
 	// base class for alloc policy
-	template <class AllocPagePolicyType = H1DefaultAllocPagePolicy>
+	template <class AllocPagePolicyType = H1DefaultAllocPagePolicy<> >
 	class H1AllocPolicy 
 	{
 	public:
 		// page definition for alloc policy
-		typedef typename AllocPagePolicyType AllocPagePolicy;
+		typedef AllocPagePolicyType AllocPagePolicy;
 
 		// page definition
 		typedef typename AllocPagePolicy::H1AllocPage AllocPage;
@@ -28,14 +28,17 @@ namespace Memory
 
 		H1BlockAllocParams()
 		{
-			h1MemCheck((BlockAlignment & ~(1 << 1)) == 0, "block alignment size should be power of two");
+			h1MemCheck((BlockAlignment & (BlockAlignment - 1)) == 0, "block alignment size should be power of two");
 		}
 	};
 
-	template <class BlockAllocParam, class AllockPagePolicy = H1DefaultAllocPagePolicy>
+	template <class BlockAllocParam, class AllockPagePolicy = H1DefaultAllocPagePolicy<> >
 	class H1BlockAllocPolicy : public BlockAllocParam, public H1AllocPolicy<AllockPagePolicy>
 	{
 	public:
+		// page definition (from dependent base class)
+		typedef typename H1AllocPolicy<AllockPagePolicy>::AllocPage AllocPage;
+
 		class H1AllocBlock
 		{
 		public:
@@ -44,7 +47,8 @@ namespace Memory
 				enum
 				{
 					BlockHeaderSize = SGD::Platform::Util::Align(sizeof(SGD::Container::SinglelyLinkedList::H1Node), BlockAllocParam::BlockAlignment),
-					BlockSize = BlockAllocParam::BlockDataSize + BlockHeaderSize,
+					// block header is linked by tagged pointer, so every block is aligned to H1Node at least
+					BlockSize = SGD::Platform::Util::Align(BlockAllocParam::BlockDataSize + BlockHeaderSize, alignof(SGD::Container::SinglelyLinkedList::H1Node)),
 				};
 
 				// get the real data pointer
@@ -54,7 +58,7 @@ namespace Memory
 				static H1AllocBlockHeader* RestoreAllocBlockHeader(byte* InData)
 				{
 					byte* RestoredHeader = InData - BlockHeaderSize;
-					return (H1AllocBlockHeader*)RestoreHeader;
+					return (H1AllocBlockHeader*)RestoredHeader;
 				}
 			};
 
@@ -72,8 +76,9 @@ namespace Memory
 		};
 
 		H1BlockAllocPolicy()
-			: FreeBlockHead(nullptr)
+			: FreeBlockHead()
 			, PageHead(nullptr)
+			, PageCount(0)
 		{
 			Initialize();
 		}
@@ -87,27 +92,37 @@ namespace Memory
 		{
 			h1MemCheck(InSize == BlockAllocParam::BlockDataSize, "size should be same as block data size!");
 
-			// if the head is nullptr, create new page
-			if (FreeBlockHead.GetNode() == nullptr)
+			// the free list can be emptied by other threads after the check, so retry until a block is popped
+			SGD::Container::SinglelyLinkedList::H1Node* NewNode = nullptr;
+			while (NewNode == nullptr)
 			{
-				CreateNewPage();
-			}
+				// if the head is nullptr, create new page
+				if (FreeBlockHead.GetNode() == nullptr)
+				{
+					CreateNewPage();
+				}
 
-			// pop new block
-			SGD::Container::SinglelyLinkedList::H1Node* NewNode = SGD::Thread::LockFreeStack::Pop(FreeBlockHead);
-			H1AllocBlock::H1AllocBlockHeader* NewBlockHeader = (H1AllocBlock::H1AllocBlockHeader*)NewNode;
+				// pop new block
+				NewNode = SGD::Thread::LockFreeStack::TryPop(FreeBlockHead);
+			}
 
+			typename H1AllocBlock::H1AllocBlockHeader* NewBlockHeader = static_cast<typename H1AllocBlock::H1AllocBlockHeader*>(NewNode);
 			return NewBlockHeader->GetData();
 		}
 
 		void Deallocate(byte* InPointer) 
 		{
-			H1AllocBlock::H1AllocBlockHeader* Header = H1AllocBlock::H1AllocBlockHeader::RestoreAllocBlockHeader(InPointer);
+			typename H1AllocBlock::H1AllocBlockHeader* Header = H1AllocBlock::H1AllocBlockHeader::RestoreAllocBlockHeader(InPointer);
 			
 			// push to the free block head
-			SGD::Thread::Push(FreeBlockHead, Header);
+			SGD::Thread::LockFreeStack::Push(FreeBlockHead, Header);
 		}
 
+		// statistics
+		int32 GetPageCount() const { return PageCount; }
+		int64 GetTotalPageSize() const { return (int64)PageCount * AllocPage::PageSize; }
+		AllockPagePolicy& GetPagePolicy() { return PagePolicy; }
+
 	protected:
 		void Initialize()
 		{
@@ -116,7 +131,7 @@ namespace Memory
 
 		void Destroy()
 		{
-			FreeBlockHead = nullptr;
+			FreeBlockHead = SGD::Thread::LockFreeStack::H1LfsHead();
 
 			// deallocate all pages
 			AllocPage* CurrPage = PageHead;
@@ -129,42 +144,60 @@ namespace Memory
 				PageToRemove->SetNext(nullptr);
 				PagePolicy.Deallocate(PageToRemove);
 			}
+
+			PageHead = nullptr;
+			PageCount = 0;
 		}
 
 		void CreateNewPage()
 		{
+			SGD::Thread::H1ScopeLock Lock(&PageSyncObject);
+
+			// other thread already created new page
+			if (FreeBlockHead.GetNode() != nullptr)
+			{
+				return;
+			}
+
 			// allocate new page
 			AllocPage* NewPage = PagePolicy.Allocate();
 
+			// link the page to release it on destruction
+			NewPage->SetNext(PageHead);
+			PageHead = NewPage;
+			PageCount++;
+
 			// create new blocks from new page
 			byte* CurrAddress = NewPage->GetData();		
 
 			H1AllocBlock* NewHead = nullptr;
 			H1AllocBlock* BlockTail = (H1AllocBlock*)CurrAddress;
 
-			int32 BlockCount = NewPage->GetSize() / H1AllocBlock::BlockSize;
+			int32 BlockCount = (int32)(NewPage->GetSize() / H1AllocBlock::H1AllocBlockHeader::BlockSize);
 			for (int32 Index = 0; Index < BlockCount; ++Index)
 			{
 				H1AllocBlock* NewBlock = (H1AllocBlock*)CurrAddress;
-				NewBlock->Layout.Header.Next = NewHead;
+				NewBlock->Layout.Header.Next = (NewHead != nullptr) ? &NewHead->Layout.Header : nullptr;
 				NewHead = NewBlock;
 
-				CurrAddress += H1AllocBlock::BlockSize;
+				CurrAddress += H1AllocBlock::H1AllocBlockHeader::BlockSize;
 			}
 
 			// link to the head (block) in lock-free
-			SGD::Thread::LockFreeStack::Push(FreeBlockHead, NewHead->Layout.Header, BlockTail->Layout.Header);
+			SGD::Thread::LockFreeStack::Push(FreeBlockHead, &NewHead->Layout.Header, &BlockTail->Layout.Header);
 		}
 
 	protected:
 		// free block head
 		SGD::Thread::LockFreeStack::H1LfsHead FreeBlockHead;
 
-		// managing the page
+		// managing the page (synchronized by PageSyncObject)
+		SGD::Thread::H1CriticalSection PageSyncObject;
 		AllocPage* PageHead;
+		int32 PageCount;
 
 		// alloc page policy type
-		AllocPagePolicy PagePolicy;
+		AllockPagePolicy PagePolicy;
 	};
 }
 }
\ No newline at end of file
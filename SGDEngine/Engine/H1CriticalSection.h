@@ -17,7 +17,7 @@ namespace Thread
 	{
 	public:
 		H1CriticalSection()
-			: OwnerThreadId(0), LockCount(0), SpinCount(0)
+			: Mutex(0), OwnerThreadId(0), LockCount(0), SpinCount(0)
 		{}
 
 		~H1CriticalSection()
@@ -40,6 +40,26 @@ namespace Thread
 			LockCount++;
 		}
 
+		// try to lock without spinning, it returns false when other thread owns the lock
+		bool TryLock()
+		{
+			H1ThreadIdType ThreadId = appGetCurrentThreadId();
+			if (ThreadId == OwnerThreadId)
+			{
+				LockCount++;
+				return true;
+			}
+
+			if (appInterlockedCompareExchange64(&Mutex, 1, 0) != 0)
+			{
+				return false;
+			}
+
+			OwnerThreadId = ThreadId;
+			LockCount++;
+			return true;
+		}
+
 		void UnLock()
 		{
 			H1ThreadIdType ThreadId = appGetCurrentThreadId();
@@ -60,8 +80,6 @@ namespace Thread
 				OwnerThreadId = 0;
 				InternalUnLock();
 			}
-
-			InternalUnLock();
 		}
 
 	protected:
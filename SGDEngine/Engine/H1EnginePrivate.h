@@ -5,6 +5,8 @@
 
 // windows-specific headers
 #include <windows.h>
+#elif __linux__
+#define SGD_LINUX_PLATFORM 1
 #endif
 
 // final release flag
@@ -27,6 +29,12 @@
 // memory
 #include "H1Memory.h"
 
+// run memory benchmarks (H1MemoryBenchmark) on engine initialization
+#define SGD_RUN_MEMORY_BENCHMARK 0
+
+// run memory regression tests (H1MemoryTest) on engine initialization
+#define SGD_RUN_MEMORY_TEST 0
+
 // thread
 #include "H1PlatformThread.h"
 
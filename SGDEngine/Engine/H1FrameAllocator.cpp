@@ -0,0 +1,159 @@
+#include "H1EnginePrivate.h"
+#include "H1FrameAllocator.h"
+
+#include "H1LaunchEngineLoop.h"
+
+// memory logger
+#include "H1MemoryLogger.h"
+
+using namespace SGD::Memory;
+
+H1FrameAllocator::H1FrameAllocator(int32 InBufferedFrameCount, H1MemoryArena::MemoryTag InTag)
+	: BufferedFrameCount(InBufferedFrameCount)
+	, CurrFrameIndex(0)
+	, Tag(InTag)
+	, FreeHead(nullptr)
+	, FreeBlockCount(0)
+	, ArenaAllocCount(0)
+	, RecycledBlockCount(0)
+{
+	h1MemCheck(BufferedFrameCount >= 1 && BufferedFrameCount <= MAX_BUFFERED_FRAME_COUNT, "invalid buffered frame count, please check!");
+
+	// start from current frame
+	Frames[CurrFrameIndex].FrameNumber = H1GlobalSingleton::LaunchEngineLoopGlobal()->FrameNumber.load();
+}
+
+H1FrameAllocator::~H1FrameAllocator()
+{
+	for (int32 FrameIndex = 0; FrameIndex < BufferedFrameCount; ++FrameIndex)
+	{
+		ReclaimFrame(Frames[FrameIndex]);
+	}
+
+	TrimFreeBlocks();
+}
+
+void H1FrameAllocator::BeginFrame()
+{
+	SGD::H1LaunchEngineLoopGlobal* LaunchEngineLoopGlobal = H1GlobalSingleton::LaunchEngineLoopGlobal();
+	uint64 FrameNumber = LaunchEngineLoopGlobal->FrameNumber.load();
+	if (FrameNumber == Frames[CurrFrameIndex].FrameNumber)
+	{
+		// the frame is not advanced
+		return;
+	}
+
+	// the oldest frame is reused for new frame
+	CurrFrameIndex = (CurrFrameIndex + 1) % BufferedFrameCount;
+	Frame& NewFrame = Frames[CurrFrameIndex];
+
+	// render thread should not read the reclaimed frame anymore
+	h1MemCheckf(NewFrame.Head == nullptr || LaunchEngineLoopGlobal->FrameNumberRenderThread.load() > NewFrame.FrameNumber, "render thread is still using the frame (%llu), please check!", NewFrame.FrameNumber);
+
+	ReclaimFrame(NewFrame);
+	NewFrame.FrameNumber = FrameNumber;
+}
+
+byte* H1FrameAllocator::Push(uint64 Size, uint64 Alignment)
+{
+	h1MemCheckf(Size + Alignment <= DATA_SIZE, "Size should be smaller than DATA_SIZE(%d KB)", DATA_SIZE / 1024);
+
+	Frame& CurrFrame = Frames[CurrFrameIndex];
+
+	byte* AllocatedAddress = SGD::Platform::Util::Align(CurrFrame.CurrAddress, Alignment);
+	if (CurrFrame.Head == nullptr || AllocatedAddress + Size > CurrFrame.EndAddress)
+	{
+		AddFrameBlock();
+		AllocatedAddress = SGD::Platform::Util::Align(CurrFrame.CurrAddress, Alignment);
+	}
+
+	CurrFrame.CurrAddress = AllocatedAddress + Size;
+	CurrFrame.UsedSize += Size;
+
+	return AllocatedAddress;
+}
+
+bool H1FrameAllocator::IsFrameAlive(uint64 FrameNumber) const
+{
+	for (int32 FrameIndex = 0; FrameIndex < BufferedFrameCount; ++FrameIndex)
+	{
+		if (Frames[FrameIndex].FrameNumber == FrameNumber && Frames[FrameIndex].Head != nullptr)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void H1FrameAllocator::TrimFreeBlocks()
+{
+	H1MemoryArena* MemoryArena = H1GlobalSingleton::MemoryArena();
+
+	while (FreeHead != nullptr)
+	{
+		FrameBlockHeader* CurrHead = FreeHead;
+		FreeHead = CurrHead->Next;
+
+		// copy the handle first, the header is in the memory block
+		H1MemoryBlock MemoryBlock = CurrHead->MemoryBlock;
+		MemoryArena->DeallocateMemoryBlock(MemoryBlock);
+	}
+
+	FreeBlockCount = 0;
+}
+
+void H1FrameAllocator::AddFrameBlock()
+{
+	FrameBlockHeader* NewHeader = nullptr;
+
+	if (FreeHead != nullptr)
+	{
+		// recycle the memory block of reclaimed frame
+		NewHeader = FreeHead;
+		FreeHead = NewHeader->Next;
+		FreeBlockCount--;
+		RecycledBlockCount++;
+	}
+	else
+	{
+		H1MemoryBlock NewMemoryBlock = H1GlobalSingleton::MemoryArena()->AllocateMemoryBlock(Tag);
+		h1MemCheck(NewMemoryBlock.BaseAddress != nullptr, "failed to allocate memory block for frame allocator (over budget), please check!");
+
+		NewHeader = (FrameBlockHeader*)NewMemoryBlock.BaseAddress;
+		NewHeader->MemoryBlock = NewMemoryBlock;
+		ArenaAllocCount++;
+	}
+
+	// link to current frame as new head
+	Frame& CurrFrame = Frames[CurrFrameIndex];
+	NewHeader->Next = CurrFrame.Head;
+	CurrFrame.Head = NewHeader;
+	if (CurrFrame.Tail == nullptr)
+	{
+		CurrFrame.Tail = NewHeader;
+	}
+
+	CurrFrame.BlockCount++;
+
+	CurrFrame.CurrAddress = (byte*)NewHeader + HEADER_SIZE;
+	CurrFrame.EndAddress = (byte*)NewHeader + H1MemoryArena::MEMORY_BLOCK_SIZE;
+}
+
+void H1FrameAllocator::ReclaimFrame(Frame& InFrame)
+{
+	if (InFrame.Head != nullptr)
+	{
+		// splice whole list to free list
+		InFrame.Tail->Next = FreeHead;
+		FreeHead = InFrame.Head;
+		FreeBlockCount += InFrame.BlockCount;
+	}
+
+	InFrame.Head = nullptr;
+	InFrame.Tail = nullptr;
+	InFrame.CurrAddress = nullptr;
+	InFrame.EndAddress = nullptr;
+	InFrame.UsedSize = 0;
+	InFrame.BlockCount = 0;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "H1MemoryArena.h"
+#include "H1GlobalSingleton.h"
+
+namespace SGD
+{
+namespace Memory
+{
+	/*
+		H1FrameAllocator
+			- linear allocator which keeps its allocations alive for BufferedFrameCount frames (like H1MemStack, but not LIFO)
+			- game thread pushes into current frame, render thread reads the data of previous frame (N-1) without copying
+			- frames are keyed off H1LaunchEngineLoopGlobal::FrameNumber, BeginFrame reclaims the oldest frame as a whole (O(1))
+			- reclaimed memory blocks are recycled for next frames, they are returned to memory arena only when it is destroyed (or trimmed)
+	*/
+	class H1FrameAllocator
+	{
+	public:
+		enum
+		{
+			MAX_BUFFERED_FRAME_COUNT = 4,
+			DEFAULT_ALIGNMENT = 16,
+		};
+
+		H1FrameAllocator(int32 InBufferedFrameCount = 2, H1MemoryArena::MemoryTag InTag = H1MemoryArena::MemoryTag_Default);
+		~H1FrameAllocator();
+
+		// start new frame (game thread, after H1LaunchEngineLoopGlobal::FrameNumber is advanced)
+		//	- the frame which is BufferedFrameCount frames before is reclaimed, so render thread should finish it (FrameNumberRenderThread)
+		void BeginFrame();
+
+		// allocate from current frame (game thread only)
+		byte* Push(uint64 Size, uint64 Alignment = DEFAULT_ALIGNMENT);
+
+		// whether the data allocated in the frame is still alive
+		bool IsFrameAlive(uint64 FrameNumber) const;
+
+		// return recycled memory blocks to memory arena
+		void TrimFreeBlocks();
+
+		// statistics
+		uint64 GetCurrentFrameNumber() const { return Frames[CurrFrameIndex].FrameNumber; }
+		uint64 GetCurrentFrameUsedSize() const { return Frames[CurrFrameIndex].UsedSize; }
+		int64 GetFreeBlockCount() const { return FreeBlockCount; }
+		// memory blocks allocated from memory arena, and reused from reclaimed frames
+		int64 GetArenaAllocCount() const { return ArenaAllocCount; }
+		int64 GetRecycledBlockCount() const { return RecycledBlockCount; }
+
+	protected:
+		// frame block header (at the beginning of each memory block)
+		struct FrameBlockHeader
+		{
+			H1MemoryBlock MemoryBlock;
+			FrameBlockHeader* Next;
+		};
+
+		enum
+		{
+			HEADER_SIZE = sizeof(FrameBlockHeader),
+			DATA_SIZE = H1MemoryArena::MEMORY_BLOCK_SIZE - HEADER_SIZE,
+		};
+
+		// buffered frame
+		//	- memory blocks are linked from the latest (Head) to the first (Tail), so whole list is spliced to free list at once
+		struct Frame
+		{
+			Frame()
+				: FrameNumber(0), Head(nullptr), Tail(nullptr), CurrAddress(nullptr), EndAddress(nullptr), UsedSize(0), BlockCount(0)
+			{}
+
+			uint64 FrameNumber;
+			FrameBlockHeader* Head;
+			FrameBlockHeader* Tail;
+			byte* CurrAddress;
+			byte* EndAddress;
+			uint64 UsedSize;
+			int64 BlockCount;
+		};
+
+		// take memory block from free list (or memory arena) and link it to current frame
+		void AddFrameBlock();
+		// move all memory blocks of the frame to free list
+		void ReclaimFrame(Frame& InFrame);
+
+		Frame Frames[MAX_BUFFERED_FRAME_COUNT];
+		int32 BufferedFrameCount;
+		int32 CurrFrameIndex;
+
+		// sub-arena of memory blocks
+		H1MemoryArena::MemoryTag Tag;
+
+		// recycled memory blocks
+		FrameBlockHeader* FreeHead;
+		int64 FreeBlockCount;
+
+		// statistics
+		int64 ArenaAllocCount;
+		int64 RecycledBlockCount;
+	};
+}
+}
@@ -2,10 +2,63 @@
 #include "H1LaunchEngineLoop.h"
 
 #include "H1WorkerThread.h"
+#include "H1FrameAllocator.h"
+
+#if SGD_RUN_MEMORY_BENCHMARK
+#include "H1MemoryBenchmark.h"
+#endif
+
+#if SGD_RUN_MEMORY_TEST
+#include "H1MemoryTest.h"
+#endif
 
 // declaring main thread context
 SGD::Thread::H1WorkerThread_Context GMainThreadContext;
 
+// per-frame allocator
+SGD::Memory::H1FrameAllocator* GFrameAllocator = nullptr;
+
+// memory arena warm-up
+//	- prefaulting on low priority background thread, so the first frame hits committed memory
+SGD::Memory::H1MemoryArena::WarmUpParams GMemoryArenaWarmUpParams;
+SGD::Thread::CreateThreadOutput GMemoryArenaWarmUpThread;
+
+DWORD WINAPI MemoryArenaWarmUpEntryPoint(LPVOID lpThreadParameter)
+{
+	H1GlobalSingleton::MemoryArena()->WarmUp(GMemoryArenaWarmUpParams);
+	return 0;
+}
+
+void StartMemoryArenaWarmUp()
+{
+	SGD::Memory::H1MemoryArena* MemoryArena = H1GlobalSingleton::MemoryArena();
+
+	// main thread's memory stack and per-frame scratch
+	GMemoryArenaWarmUpParams.PageCounts[SGD::Memory::H1MemoryArena::MemoryTag_Default] = 1;
+	GMemoryArenaWarmUpParams.BlockCounts[SGD::Memory::H1MemoryArena::MemoryTag_Default] = 16;
+	GMemoryArenaWarmUpParams.PageCounts[SGD::Memory::H1MemoryArena::MemoryTag_JobScratch] = 1;
+	GMemoryArenaWarmUpParams.BlockCounts[SGD::Memory::H1MemoryArena::MemoryTag_JobScratch] = 8;
+	GMemoryArenaWarmUpParams.PageCounts[SGD::Memory::H1MemoryArena::MemoryTag_Containers] = 1;
+	GMemoryArenaWarmUpParams.BlockCounts[SGD::Memory::H1MemoryArena::MemoryTag_Containers] = 4;
+
+	// pages are for the main thread's NUMA node
+	GMemoryArenaWarmUpParams.NumaNode = SGD::Platform::Util::appGetCurrentNumaNode() % MemoryArena->GetNumaNodeCount();
+
+	SGD::Thread::CreateThreadInput Input;
+	Input.StackSize = 64 * 1024;
+
+	if (SGD::Thread::appCreateThread(GMemoryArenaWarmUpThread, Input, MemoryArenaWarmUpEntryPoint))
+	{
+		SGD::Thread::appSetThreadLowPriority(GMemoryArenaWarmUpThread.ThreadHandle);
+	}
+	else
+	{
+		// warm up synchronously
+		GMemoryArenaWarmUpThread.ThreadHandle = nullptr;
+		MemoryArena->WarmUp(GMemoryArenaWarmUpParams);
+	}
+}
+
 void Init()
 {
 	// initialize main thread context
@@ -14,6 +67,21 @@ void Init()
 
 	// setting GWorkerThreadContext as main thread
 	GWorkerThreadContext = &GMainThreadContext;
+
+#if SGD_RUN_MEMORY_TEST
+	SGD::Memory::H1MemoryTest::RunAll();
+#endif
+
+#if SGD_RUN_MEMORY_BENCHMARK
+	// before warm-up, so the benchmark doesn't compete with the warm-up thread
+	SGD::Memory::H1MemoryBenchmark::RunAll();
+#endif
+
+	// start prefaulting memory arena (see H1MemoryArena::GetWarmUpReport for how much is prewarmed and how long it took)
+	StartMemoryArenaWarmUp();
+
+	// per-frame allocator (starts from current frame)
+	GFrameAllocator = new SGD::Memory::H1FrameAllocator();
 }
 
 void Run()
@@ -35,9 +103,43 @@ void Run()
 
 	Temp* aTemps = new (GWorkerThreadContext->MemStack) Temp[10];
 	aTemps[5].a = 100;
+
+	SGD::Memory::H1MemoryArena* MemoryArena = H1GlobalSingleton::MemoryArena();
+
+	// frame end: flush all threads' deferred frees, and advance the frame
+	SGD::H1LaunchEngineLoopGlobal* LaunchEngineLoopGlobal = H1GlobalSingleton::LaunchEngineLoopGlobal();
+	MemoryArena->FlushAllDeferredFrees();
+	uint64 FrameNumber = ++LaunchEngineLoopGlobal->FrameNumber;
+	MemoryArena->SetDeferredFreeFrame(FrameNumber);
+
+	// there is no render thread yet, the main thread has finished the frames before the new frame
+	LaunchEngineLoopGlobal->FrameNumberRenderThread = FrameNumber;
+
+	// reclaim the oldest frame of the frame allocator (after render thread frame is advanced)
+	GFrameAllocator->BeginFrame();
+
+	// trim spare memory tags of main thread memory stack
+	GMainThreadContext.MemStack.Tick();
+
+	// return idle memory blocks to OS (per-frame purge, it is cheap when there is nothing to purge)
+	MemoryArena->PurgeMemoryBlocks();
 }
 
 void Destroy()
 {
+	// return memory blocks of the frame allocator
+	delete GFrameAllocator;
+	GFrameAllocator = nullptr;
+
+	// wait for the warm-up thread
+	if (GMemoryArenaWarmUpThread.ThreadHandle != nullptr)
+	{
+		SGD::Thread::JointThreadInput Input;
+		Input.NumThreads = 1;
+		Input.ThreadArray = &GMemoryArenaWarmUpThread.ThreadHandle;
+
+		SGD::Thread::appJoinThreads(Input);
+		GMemoryArenaWarmUpThread.ThreadHandle = nullptr;
+	}
 
 }
\ No newline at end of file
@@ -17,12 +17,21 @@ namespace SGD
 			, FrameNumberRenderThread(0)
 		{}
 
-		uint64 FrameNumber;
-		uint64 FrameNumberRenderThread;
+		// frame counters are read across threads (render thread, frame allocator)
+		SGD::atomic<uint64> FrameNumber;
+		SGD::atomic<uint64> FrameNumberRenderThread;
 	};
 
+	namespace Memory
+	{
+		// forward declaration
+		class H1FrameAllocator;
+	}
 }
 
+// per-frame allocator of main thread (created in Init, BeginFrame at the frame boundary in Run)
+extern SGD::Memory::H1FrameAllocator* GFrameAllocator;
+
 // extern functionality for entering main thread (same as H1WorkerThread_Impl)
 
 extern void Init();
@@ -11,11 +11,14 @@ namespace LockFreeStack
 	// preventing naming confusion
 	class H1LfsHead : public H1TaggedPointer
 	{
-
+	public:
+		H1LfsHead() {}
+		// restoring from the result of interlocked operation
+		explicit H1LfsHead(int64 InData) : H1TaggedPointer(InData) {}
 	};
 
 	// lock free stack implementation
-	void Push(H1LfsHead& Head, H1LfsHead::NodeType* InNode)
+	inline void Push(H1LfsHead& Head, H1LfsHead::NodeType* InNode)
 	{
 		H1LfsHead NewHead;
 		H1LfsHead OldHead;
@@ -31,7 +34,7 @@ namespace LockFreeStack
 		} while ((H1LfsHead)SGD::Thread::appInterlockedCompareExchange64((volatile int64*)&Head, (int64)NewHead, (int64)OldHead) != OldHead);
 	}
 
-	void Push(H1LfsHead& Head, H1LfsHead::NodeType* InNodeHead, H1LfsHead::NodeType* InNodeTail)
+	inline void Push(H1LfsHead& Head, H1LfsHead::NodeType* InNodeHead, H1LfsHead::NodeType* InNodeTail)
 	{
 		H1LfsHead NewHead;
 		H1LfsHead OldHead;
@@ -46,9 +49,8 @@ namespace LockFreeStack
 
 		} while ((H1LfsHead)SGD::Thread::appInterlockedCompareExchange64((volatile int64*)&Head, (int64)NewHead, (int64)OldHead) != OldHead);
 	}
-	}
 
-	H1LfsHead::NodeType* Pop(H1LfsHead& Head)
+	inline H1LfsHead::NodeType* Pop(H1LfsHead& Head)
 	{
 		H1LfsHead NewHead;
 		H1LfsHead OldHead;
@@ -65,7 +67,29 @@ namespace LockFreeStack
 		return OldHead.GetNode();
 	}
 
-	H1LfsHead::NodeType* PopAll(H1LfsHead& Head)
+	// same as Pop, but returns nullptr when the stack is empty
+	inline H1LfsHead::NodeType* TryPop(H1LfsHead& Head)
+	{
+		H1LfsHead NewHead;
+		H1LfsHead OldHead;
+		do
+		{
+			OldHead = Head;
+			if (OldHead.GetNode() == nullptr)
+			{
+				return nullptr;
+			}
+
+			NewHead = OldHead;
+			NewHead.SetNode(OldHead.GetNode()->Next);
+			NewHead.IncrementTag();
+
+		} while ((H1LfsHead)SGD::Thread::appInterlockedCompareExchange64((volatile int64*)&Head, (int64)NewHead, (int64)OldHead) != OldHead);
+
+		return OldHead.GetNode();
+	}
+
+	inline H1LfsHead::NodeType* PopAll(H1LfsHead& Head)
 	{
 		H1LfsHead NewHead;
 		H1LfsHead OldHead;
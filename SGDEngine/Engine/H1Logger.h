@@ -90,14 +90,26 @@ namespace Log
 			LogCountLimit = LogCountPerPage,
 
 			// preventing ABA problem
-			AddressBitNum		= 44,	// in windows system, maximum allowed bits is 44
+			AddressBitNum		= 44,	// logs are aligned to pointer size, so 44 bits keep x64 user-space address (47 bits) shifted by AddressShift
 			AddressTagBitNum	= 20,
+			AddressShift		= 3,
 		};
 
 		// address mask for preventing ABA problem
 		const uint64 AddressTagMask		= (uint64)(~0) << AddressBitNum;
 		const uint64 AddressMask		= (uint64)(~0) >> AddressTagBitNum;
 
+		// tagged free head
+		H1Log<CharType>* MakeTaggedHead(H1Log<CharType>* InLog, uint64 InTag)
+		{
+			return (H1Log<CharType>*)(((uint64)InLog >> AddressShift) | (InTag << AddressBitNum));
+		}
+
+		H1Log<CharType>* GetHeadLog(H1Log<CharType>* InHead)
+		{
+			return (H1Log<CharType>*)(((uint64)InHead & AddressMask) << AddressShift);
+		}
+
 		// real data layout
 		struct LoggerLayout
 		{
@@ -123,20 +135,22 @@ namespace Log
 			memset(Data, 0, sizeof(Data));
 
 			// create free list
+			H1Log<CharType>* FreeHead = nullptr;
 			for (int32 Index = 0; Index < LogCountPerPage; ++Index)
 			{
 				H1Log<CharType>* CurrLog = &Layout.Logs[Index];
 
-				CurrLog->Next = Layout.Header.FreeHead;
-				Layout.Header.FreeHead = CurrLog;
+				CurrLog->Next = FreeHead;
+				FreeHead = CurrLog;
 			}
+			Layout.Header.FreeHead = MakeTaggedHead(FreeHead, 0);
 		}
 
 		// create new log
 		//	- give temporary log pointer (this should be used as scoped pointer do not store this as member variables)
 		H1Log<CharType>* CreateLog()
 		{
-			if (Layout.Header.FreeHead == nullptr)
+			if (GetHeadLog(Layout.Header.FreeHead) == nullptr)
 			{
 				// it could happen dumping multiple time, when the logs is out of stock, but it is just happened at that moment
 				// after that, it resolve all problems and just running on normal
@@ -156,14 +170,14 @@ namespace Log
 				Tag++;	// increment tag count
 
 				// extract real data address
-				H1Log<CharType>* Data = (H1Log<CharType>*)((uint64)OldHead & AddressMask);
+				H1Log<CharType>* Data = GetHeadLog(OldHead);
 				Result = Data;
 
 				NewHead = Data->Next;
 				// add tag count to the new head
-				NewHead = (H1Log<CharType>*)((uint64)NewHead | (Tag << AddressBitNum));
+				NewHead = MakeTaggedHead(NewHead, Tag);
 
-			} while (Layout.Header.FreeHead != nullptr && (H1Log<CharType>*)SGD::Thread::appInterlockedCompareExchange64((volatile int64*)&(Layout.Header.FreeHead), (int64)NewHead, (int64)OldHead) != OldHead);
+			} while (GetHeadLog(Layout.Header.FreeHead) != nullptr && (H1Log<CharType>*)SGD::Thread::appInterlockedCompareExchange64((volatile int64*)&(Layout.Header.FreeHead), (int64)NewHead, (int64)OldHead) != OldHead);
 
 			return Result;
 		}
@@ -184,12 +198,12 @@ namespace Log
 				Tag++;	// increment tag count
 
 				// extract real data address
-				H1Log<CharType>* Data = (H1Log<CharType>*)((uint64)OldHead & AddressMask);
+				H1Log<CharType>* Data = GetHeadLog(OldHead);
 				Result = Data;
 
 				NewHead = nullptr;
 				// add tag count to the new head
-				NewHead = (H1Log<CharType>*)((uint64)NewHead | (Tag << AddressBitNum));
+				NewHead = MakeTaggedHead(NewHead, Tag);
 
 			} while ((H1Log<CharType>*)SGD::Thread::appInterlockedCompareExchange64((volatile int64*)&(Layout.Header.FreeHead), (int64)NewHead, (int64)OldHead) != OldHead);
 
@@ -212,7 +226,7 @@ namespace Log
 
 				NewHead = Result;
 				// add tag count to the new head
-				NewHead = (H1Log<CharType>*)((uint64)NewHead | (Tag << AddressBitNum));
+				NewHead = MakeTaggedHead(NewHead, Tag);
 
 			} while ((H1Log<CharType>*)SGD::Thread::appInterlockedCompareExchange64((volatile int64*)&(Layout.Header.FreeHead), (int64)NewHead, (int64)OldHead) != OldHead);
 		}
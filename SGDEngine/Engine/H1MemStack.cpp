@@ -7,67 +7,152 @@
 using namespace SGD::Memory;
 
 #if !FINAL_RELEASE
-void H1MemStack::CreateTrackStackAlloc(byte* StartAddress, uint64 Size)
+void H1MemStack::CreateTrackStackAlloc(byte* StartAddress, uint64 Size, uint64 ConsumedSize)
 {
-	// create new node
-	H1TrackStackAlloc* NewNode = new H1TrackStackAlloc();
-	NewNode->Next = TrackStackAllocHead;
-	NewNode->StartAddress = StartAddress;
-	NewNode->Size = Size;
-	NewNode->MemoryTag = Head;
+	if (TrackStackAllocDepth < TRACK_STACK_ALLOC_CAPACITY)
+	{
+		H1TrackStackAlloc& NewRecord = TrackStackAllocs[TrackStackAllocDepth];
+		NewRecord.StartAddress = StartAddress;
+		NewRecord.Size = Size;
+		NewRecord.ConsumedSize = ConsumedSize;
+	}
+	else
+	{
+		UntrackedAllocCount++;
+	}
+	TrackStackAllocDepth++;
 
-	// update head
-	TrackStackAllocHead = NewNode;
+	UsedSize += ConsumedSize;
+	UpdatePeakUsedSize();
 }
 
-void H1MemStack::ReleaseCurrentHeadTrackStackAllocInternal()
+void H1MemStack::UpdatePeakUsedSize()
 {
-	// release head node
-	H1TrackStackAlloc* RemoveNode = TrackStackAllocHead;
-	// update the node first
-	TrackStackAllocHead = TrackStackAllocHead->Next;
-	// delete the node
-	delete RemoveNode;
+	// update peak usage (the peak of the top memory mark is propagated to outer one when it is popped)
+	if (UsedSize > PeakUsedSize)
+	{
+		PeakUsedSize = UsedSize;
+	}
+	if (MarkHead != nullptr && UsedSize > MarkHead->PeakUsedSize)
+	{
+		MarkHead->PeakUsedSize = UsedSize;
+	}
 }
 
 void H1MemStack::ReleaseTrackStackAlloc(byte* StartAddress, uint64 Size)
 {
-	// check whether current head has same Size
-	h1MemCheckf(TrackStackAllocHead->Size == Size, "invalid operation to release the memory stack (%d != %d)", TrackStackAllocHead->Size, Size);
-	h1MemCheckf(TrackStackAllocHead->StartAddress == StartAddress, "invalid operation to release the memory stack (%x != %x)", TrackStackAllocHead->StartAddress, StartAddress);
+	h1MemCheck(TrackStackAllocDepth > 0, "invalid operation to release the memory stack (nothing is pushed)");
 
-	ReleaseCurrentHeadTrackStackAllocInternal();
+	// release every record in the popped range [StartAddress, CurrAddress) of current memory tag
+	//	- Pop by pointer can cover several pushes (e.g. New/NewArray pushes the object and its destructor record above it)
+	//	- each record returns its consumed size (including alignment padding), so the usage doesn't creep up by the padding
+	byte* LastStartAddress = nullptr;
+	while (TrackStackAllocDepth > 0)
+	{
+		if (TrackStackAllocDepth > TRACK_STACK_ALLOC_CAPACITY)
+		{
+			// untracked push, its address and padding are unknown (only one is released by Size)
+			TrackStackAllocDepth--;
+			LastStartAddress = StartAddress;
+			UsedSize -= Size;
+			break;
+		}
+
+		H1TrackStackAlloc& Record = TrackStackAllocs[TrackStackAllocDepth - 1];
+		if (Record.StartAddress < StartAddress || Record.StartAddress > CurrAddress)
+		{
+			break;
+		}
+
+		LastStartAddress = Record.StartAddress;
+		UsedSize -= Record.ConsumedSize;
+		TrackStackAllocDepth--;
+	}
+
+	// the popped range should start at the allocation
+	h1MemCheckf(LastStartAddress == StartAddress, "invalid operation to release the memory stack (%x != %x)", LastStartAddress, StartAddress);
 }
 
-void H1MemStack::ReleaseTackStackAllocByAddress(byte* EndAddress, MemoryTagHeader* MemoryTag)
+void H1MemStack::ResizeTrackStackAlloc(byte* StartAddress, uint64 OldSize, uint64 NewSize)
 {
-	// while reaching to the MemoryTag, release TrackStackAlloc
-	while (TrackStackAllocHead != nullptr && TrackStackAllocHead->MemoryTag != MemoryTag)
+	h1MemCheck(TrackStackAllocDepth > 0, "invalid operation to resize the memory stack (nothing is pushed)");
+
+	// the top record should be the resized allocation
+	if (TrackStackAllocDepth <= TRACK_STACK_ALLOC_CAPACITY)
 	{
-		ReleaseCurrentHeadTrackStackAllocInternal();
+		H1TrackStackAlloc& Record = TrackStackAllocs[TrackStackAllocDepth - 1];
+		h1MemCheckf(Record.Size == OldSize, "invalid operation to resize the memory stack (%d != %d)", Record.Size, OldSize);
+		h1MemCheckf(Record.StartAddress == StartAddress, "invalid operation to resize the memory stack (%x != %x)", Record.StartAddress, StartAddress);
+
+		Record.Size = NewSize;
+		Record.ConsumedSize = Record.ConsumedSize - OldSize + NewSize;
+	}
+
+	UsedSize = UsedSize - OldSize + NewSize;
+	UpdatePeakUsedSize();
+}
+
+void H1MemStack::ReleaseTrackStackAllocByMark(H1MemMark* Mark)
+{
+	h1MemCheck(TrackStackAllocDepth >= Mark->MarkedTrackStackAllocDepth, "please check did you put valid memory mark!");
+
+	// release the records pushed after the memory mark
+	TrackStackAllocDepth = Mark->MarkedTrackStackAllocDepth;
+	UsedSize = Mark->MarkedUsedSize;
+
+	// propagate peak usage to outer memory mark
+	if (Mark->Next != nullptr && Mark->PeakUsedSize > Mark->Next->PeakUsedSize)
+	{
+		Mark->Next->PeakUsedSize = Mark->PeakUsedSize;
 	}
 
-	h1MemCheck(TrackStackAllocHead != nullptr, "please check did you put valid memory tag!");
+	if (Mark->Name != nullptr)
+	{
+		RecordMarkReport(Mark->Name, Mark->GetPeakUsedSize());
+	}
+}
 
-	// now, we are reaching to the memory tag and until reaching EndAddress, release node
-	while (TrackStackAllocHead->MemoryTag == MemoryTag && TrackStackAllocHead->StartAddress != EndAddress)
+void H1MemStack::RecordMarkReport(const char* Name, uint64 MarkPeakUsedSize)
+{
+	// find the report by name (linear search, there are only few named memory marks)
+	H1MemMarkReport* Report = nullptr;
+	for (int32 Index = 0; Index < MarkReportCount; ++Index)
 	{
-		ReleaseCurrentHeadTrackStackAllocInternal();
+		if (MarkReports[Index].Name == Name)
+		{
+			Report = &MarkReports[Index];
+			break;
+		}
 	}
 
-	h1MemCheck(TrackStackAllocHead->MemoryTag == MemoryTag, "please check did you put valid end address!");
-	h1MemCheck(TrackStackAllocHead->StartAddress == EndAddress, "please check did you put valid end address!");
+	if (Report == nullptr)
+	{
+		if (MarkReportCount == MAX_MARK_REPORT_COUNT)
+		{
+			// reports are full
+			return;
+		}
 
-	// lastly release the track stack alloc internally
-	ReleaseCurrentHeadTrackStackAllocInternal();
+		Report = &MarkReports[MarkReportCount++];
+		Report->Name = Name;
+		Report->PeakUsedSize = 0;
+		Report->PopCount = 0;
+	}
+
+	if (MarkPeakUsedSize > Report->PeakUsedSize)
+	{
+		Report->PeakUsedSize = MarkPeakUsedSize;
+	}
+	Report->PopCount++;
 }
 
-void H1MemStack::ReleaseTackStackAllocAll()
-{	
-	// looping the list and release the nodes
-	while (TrackStackAllocHead != nullptr)
+void H1MemStack::DumpMarkReports() const
+{
+	h1MemDebugf("memory stack peak usage: %llu KB (untracked pushes: %lld)", PeakUsedSize / 1024, UntrackedAllocCount);
+	for (int32 Index = 0; Index < MarkReportCount; ++Index)
 	{
-		ReleaseCurrentHeadTrackStackAllocInternal();
+		const H1MemMarkReport& Report = MarkReports[Index];
+		h1MemDebugf("\t%s: peak %llu KB (pop count: %lld)", Report.Name, Report.PeakUsedSize / 1024, Report.PopCount);
 	}
 }
 #endif
@@ -76,25 +161,70 @@ H1MemStack::H1MemStack()
 	: Head(nullptr)
 	, MarkHead(nullptr)
 	, CurrAddress(nullptr)
+	, SpareHead(nullptr)
+	, SpareTagCount(0)
+	, MaxSpareTagCount(DEFAULT_MAX_SPARE_TAG_COUNT)
+	, DestructorHead(nullptr)
+	, CreatedTagCount(0)
+	, ReusedTagCount(0)
+	, TrimmedTagCount(0)
+	, SpilledTagCount(0)
+	, GrowInPlaceCount(0)
+	, GrowCopyCount(0)
 #if !FINAL_RELEASE
-	, TrackStackAllocHead(nullptr)
+	, TrackStackAllocBlock(-1, -1)
+	, TrackStackAllocs(nullptr)
+	, TrackStackAllocDepth(0)
+	, UntrackedAllocCount(0)
+	, UsedSize(0)
+	, PeakUsedSize(0)
+	, MarkReportCount(0)
 #endif
 {
+#if !FINAL_RELEASE
+	// preallocate tracking records from memory arena
+	TrackStackAllocBlock = H1GlobalSingleton::MemoryArena()->AllocateMemoryBlock();
+	TrackStackAllocs = (H1TrackStackAlloc*)TrackStackAllocBlock.BaseAddress;
+#endif
+
 	// create new head in the constructor
-	Head = MemoryTagFactory::CreateMemoryTag(Head);
+	Head = CreateMemoryTag(Head);
 	// set current address of head memory tag
 	CurrAddress = Head->GetStartAddress();
 }
 
 H1MemStack::~H1MemStack()
 {
+	// run destructors which are not popped by memory mark
+	RunDestructors(nullptr);
+
+	// return memory tags in use (including the head created in the constructor) to memory arena
+	while (Head != nullptr)
+	{
+		MemoryTagHeader* HeaderToRemove = Head;
+		Head = Head->Next;
+
+		MemoryTagFactory::DestroyMemoryTag(HeaderToRemove);
+	}
+	CurrAddress = nullptr;
 
+	// return spare memory tags to memory arena
+	TrimSpareTags(0);
+
+#if !FINAL_RELEASE
+	H1GlobalSingleton::MemoryArena()->DeallocateMemoryBlock(TrackStackAllocBlock);
+#endif
+}
+
+void H1MemStack::Tick()
+{
+	TrimSpareTags(MaxSpareTagCount);
 }
 
 // push the memory size
-byte* H1MemStack::Push(uint64 Size)
+byte* H1MemStack::Push(uint64 Size, uint64 Alignment)
 {
-	h1MemCheckf(Size < MemoryTag::DATA_SIZE, "Size should be smaller than MemoryTag::DATA_SIZE(%d KB)", MemoryTag::DATA_SIZE / 1024);
+	h1MemCheckf((Alignment & (Alignment - 1)) == 0, "Alignment should be power of two (%d)", Alignment);
 
 	byte* BaseAddress = nullptr;
 	uint64 AllocatedSize = 0;
@@ -109,8 +239,9 @@ byte* H1MemStack::Push(uint64 Size)
 		// check if the current memory tag has available size
 		BaseAddress = Head->GetStartAddress();
 
-		AllocatedSize = CurrAddress - BaseAddress;
-		AvailableSize = MemoryTag::DATA_SIZE - AllocatedSize;
+		// the padding for alignment is included
+		AllocatedSize = SGD::Platform::Util::Align(CurrAddress, Alignment) - BaseAddress;
+		AvailableSize = (AllocatedSize < Head->DataSize) ? Head->DataSize - AllocatedSize : 0;
 	}
 
 	if (Size > AvailableSize)
@@ -121,36 +252,53 @@ byte* H1MemStack::Push(uint64 Size)
 			Head->EndAddress = CurrAddress;
 		}
 
-		// allocate new memory tag
-		Head = MemoryTagFactory::CreateMemoryTag(Head);
+		if (Size + Alignment < MemoryTag::DATA_SIZE)
+		{
+			// allocate new memory tag
+			Head = CreateMemoryTag(Head);
+		}
+		else
+		{
+			// oversized push spills into contiguous memory blocks
+			Head = MemoryTagFactory::CreateSpilledMemoryTag(Size + Alignment, Head);
+			SpilledTagCount++;
+		}
 
 		// update the properties
 		CurrAddress = Head->GetStartAddress();
 	}
 
 	// move the memory address
-	byte* AllocatedAddress = CurrAddress;
-	CurrAddress += Size;
-
+	byte* AllocatedAddress = SGD::Platform::Util::Align(CurrAddress, Alignment);
 #if !FINAL_RELEASE
-	CreateTrackStackAlloc(AllocatedAddress, Size);
+	CreateTrackStackAlloc(AllocatedAddress, Size, AllocatedAddress + Size - CurrAddress);
 #endif
+	CurrAddress = AllocatedAddress + Size;
 
 	return AllocatedAddress;
 }
 
 bool H1MemStack::Pop(uint64 Size)
 {
-	h1MemCheckf(Size < MemoryTag::DATA_SIZE, "Size should be smaller than MemoryTag::DATA_SIZE(%d KB)", MemoryTag::DATA_SIZE / 1024);
+	h1MemCheckf(Size <= (uint64)(CurrAddress - Head->GetStartAddress()), "Size should be in the current memory tag (%d KB)", Size / 1024);
 
 	// mark address should be higher than updated curr address (subtracted by size)
-	h1MemCheckf(MarkHead->MarkedAddress < CurrAddress - Size, "please check the range of memory mark");
+	h1MemCheckf(MarkHead == nullptr || MarkHead->MarkedMemoryTag != Head || MarkHead->MarkedAddress <= CurrAddress - Size, "please check the range of memory mark");
+
+#if !FINAL_RELEASE
+	ReleaseTrackStackAlloc(CurrAddress - Size, Size);
+#endif
+
+	// run destructors registered in the popped range (their records would be overwritten by next push)
+	RunDestructorsAbove(CurrAddress - Size);
 
 	uint64 CurrSize = Size;
 
 	// if the current address reach to the head release the memory tag
+	//	- the first memory tag and the memory tag marked by the top mem mark are kept (H1MemMark frees memory tags reaching to its marked one)
 	byte* StartAddress = Head->GetStartAddress();
-	if (StartAddress >= CurrAddress - Size)
+	bool bMarkedMemoryTag = (MarkHead != nullptr && MarkHead->MarkedMemoryTag == Head);
+	if (StartAddress >= CurrAddress - Size && Head->Next != nullptr && !bMarkedMemoryTag)
 	{
 		// update current address
 		CurrSize -= (CurrAddress - StartAddress);
@@ -162,10 +310,6 @@ bool H1MemStack::Pop(uint64 Size)
 	// finally update current address
 	CurrAddress -= CurrSize;
 
-#if !FINAL_RELEASE
-	ReleaseTrackStackAlloc(CurrAddress, Size);
-#endif
-
 	return true;
 }
 
@@ -175,6 +319,75 @@ bool H1MemStack::Pop(void* Pointer)
 	return Pop(Size);
 }
 
+bool H1MemStack::TryGrowInPlace(void* Pointer, uint64 OldSize, uint64 NewSize)
+{
+	byte* Address = (byte*)Pointer;
+
+	// the allocation should be on top of current memory tag
+	byte* StartAddress = Head->GetStartAddress();
+	if (Address < StartAddress || Address + OldSize != CurrAddress)
+	{
+		return false;
+	}
+
+	// current memory tag should have room
+	if (Address + NewSize > StartAddress + Head->DataSize)
+	{
+		return false;
+	}
+
+#if !FINAL_RELEASE
+	ResizeTrackStackAlloc(Address, OldSize, NewSize);
+#endif
+
+	CurrAddress = Address + NewSize;
+	return true;
+}
+
+byte* H1MemStack::Grow(void* Pointer, uint64 OldSize, uint64 NewSize, uint64 Alignment)
+{
+	h1MemCheckf(NewSize >= OldSize, "please use Shrink (%d < %d)", NewSize, OldSize);
+
+	if (TryGrowInPlace(Pointer, OldSize, NewSize))
+	{
+		GrowInPlaceCount++;
+		return (byte*)Pointer;
+	}
+
+	// push new allocation and copy
+	byte* NewAddress = Push(NewSize, Alignment);
+	SGD::Platform::Util::appMemcpy((const byte*)Pointer, NewAddress, OldSize);
+	GrowCopyCount++;
+
+	return NewAddress;
+}
+
+bool H1MemStack::Shrink(void* Pointer, uint64 OldSize, uint64 NewSize)
+{
+	h1MemCheckf(NewSize <= OldSize, "please use Grow (%d > %d)", NewSize, OldSize);
+
+	byte* Address = (byte*)Pointer;
+
+	// the allocation which is not on top keeps its memory until memory mark is popped
+	if (Address < Head->GetStartAddress() || Address + OldSize != CurrAddress)
+	{
+		return false;
+	}
+
+	if (NewSize == 0)
+	{
+		// release the allocation as a whole, so its tracking record is popped as well
+		return Pop(Pointer);
+	}
+
+#if !FINAL_RELEASE
+	ResizeTrackStackAlloc(Address, OldSize, NewSize);
+#endif
+
+	CurrAddress = Address + NewSize;
+	return true;
+}
+
 void H1MemStack::FreeMemoryTags(MemoryTagHeader* NewHead)
 {
 	// looping memory tags
@@ -188,7 +401,98 @@ void H1MemStack::FreeMemoryTags(MemoryTagHeader* NewHead)
 		// restore the curr address
 		CurrAddress = Head->EndAddress;
 
-		// destroy current memory tag
-		MemoryTagFactory::DestroyMemoryTag(CurrHead);
+		// keep current memory tag as spare
+		ReleaseMemoryTag(CurrHead);
+	}
+}
+
+H1MemStack::MemoryTagHeader* H1MemStack::CreateMemoryTag(MemoryTagHeader* Next)
+{
+	if (SpareHead == nullptr)
+	{
+		CreatedTagCount++;
+		return MemoryTagFactory::CreateMemoryTag(Next);
+	}
+
+	// reuse the last freed memory tag (memory block and memory tag indicator are still valid)
+	MemoryTagHeader* Header = SpareHead;
+	SpareHead = Header->Next;
+	SpareTagCount--;
+	ReusedTagCount++;
+
+	Header->Next = Next;
+	return Header;
+}
+
+void H1MemStack::ReleaseMemoryTag(MemoryTagHeader* Header)
+{
+	if (Header->IsSpilled())
+	{
+		// spilled memory tag is not reused (its size varies)
+		MemoryTagFactory::DestroyMemoryTag(Header);
+		return;
+	}
+
+	Header->Next = SpareHead;
+	SpareHead = Header;
+	SpareTagCount++;
+}
+
+void H1MemStack::TrimSpareTags(int32 RetainCount)
+{
+	// skip the last freed memory tags to retain
+	MemoryTagHeader** Link = &SpareHead;
+	for (int32 Index = 0; Index < RetainCount && *Link != nullptr; ++Index)
+	{
+		Link = &(*Link)->Next;
+	}
+
+	// destroy the rest
+	MemoryTagHeader* CurrHeader = *Link;
+	*Link = nullptr;
+
+	while (CurrHeader != nullptr)
+	{
+		MemoryTagHeader* HeaderToRemove = CurrHeader;
+		CurrHeader = CurrHeader->Next;
+
+		MemoryTagFactory::DestroyMemoryTag(HeaderToRemove);
+		SpareTagCount--;
+		TrimmedTagCount++;
+	}
+}
+
+void H1MemStack::RunDestructors(H1StackDestructor* NewHead)
+{
+	// looping registered destructors (from the latest)
+	while (DestructorHead != NewHead)
+	{
+		H1StackDestructor* CurrDestructor = DestructorHead;
+
+		// update head first
+		DestructorHead = CurrDestructor->Next;
+
+		CurrDestructor->Destruct(CurrDestructor->Objects, CurrDestructor->Count);
+	}
+}
+
+void H1MemStack::RunDestructorsAbove(byte* Address)
+{
+	// records in the current memory tag are pushed in increasing address order, so the ones above Address are at the head
+	byte* StartAddress = Head->GetStartAddress();
+	while (DestructorHead != nullptr)
+	{
+		byte* RecordAddress = (byte*)DestructorHead;
+		if (RecordAddress < Address || RecordAddress < StartAddress || RecordAddress >= CurrAddress)
+		{
+			break;
+		}
+
+		H1StackDestructor* CurrDestructor = DestructorHead;
+
+		// update head first
+		DestructorHead = CurrDestructor->Next;
+
+		CurrDestructor->Destruct(CurrDestructor->Objects, CurrDestructor->Count);
 	}
 }
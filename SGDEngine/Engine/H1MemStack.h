@@ -7,9 +7,14 @@ namespace SGD
 {
 namespace Memory
 {
+	// forward declaration
+	class H1MemMark;
+
 	/*
 		H1MemoryStack
 			- motivated from UE3 (MemoryStack)
+			- typed allocations (New/NewArray) of non-trivially destructible types register their destructors, H1MemMark runs them in reverse order when it is popped
+			- oversized push (bigger than a memory tag) spills into contiguous memory blocks (H1MemoryBlockRange) linked as a memory tag
 	*/
 	class H1MemStack
 	{
@@ -17,15 +22,93 @@ namespace Memory
 		H1MemStack();
 		~H1MemStack();
 
-		byte* Push(uint64 Size);
+		// push the memory size (Alignment should be power of two)
+		byte* Push(uint64 Size, uint64 Alignment = DEFAULT_ALIGNMENT);
+		// pop the memory size
+		//	- destructors registered by New/NewArray in the popped range are run (others are run by H1MemMark)
 		bool Pop(uint64 Size);
 		bool Pop(void* Pointer);
 
-		void Tick()
+		// resize the top allocation (Pointer, OldSize) in place
+		//	- it only succeeds when the allocation is on top and current memory tag has room
+		bool TryGrowInPlace(void* Pointer, uint64 OldSize, uint64 NewSize);
+		// grow the allocation, falls back to push and copy (the old allocation is abandoned until memory mark is popped)
+		byte* Grow(void* Pointer, uint64 OldSize, uint64 NewSize, uint64 Alignment = DEFAULT_ALIGNMENT);
+		// shrink the allocation, the memory is returned only when the allocation is on top (returns false otherwise)
+		//	- shrinking to zero pops the allocation (the pointer is not valid anymore)
+		bool Shrink(void* Pointer, uint64 OldSize, uint64 NewSize);
+
+		// typed allocation
+		//	- trivially destructible types have no overhead, others register their destructor (allocated in the memory stack)
+		template <class Type, class... ArgTypes>
+		Type* New(ArgTypes&&... Args)
+		{
+			Type* Object = new (Push(sizeof(Type), alignof(Type))) Type(std::forward<ArgTypes>(Args)...);
+			RegisterDestructor(Object, 1, SGD::is_trivially_destructible<Type>());
+			return Object;
+		}
+
+		template <class Type>
+		Type* NewArray(uint64 Count)
 		{
-			//MarkHead == nullptr
+			Type* Objects = (Type*)Push(sizeof(Type) * Count, alignof(Type));
+			for (uint64 Index = 0; Index < Count; ++Index)
+			{
+				new (&Objects[Index]) Type();
+			}
+			RegisterDestructor(Objects, Count, SGD::is_trivially_destructible<Type>());
+			return Objects;
 		}
 
+		// trim spare memory tags down to MaxSpareTagCount (called once per frame)
+		void Tick();
+
+		// spare memory tag retention
+		//	- freed memory tags are kept in the spare list instead of returning to memory arena, and reused by next push
+		//	- Tick keeps the last MaxSpareTagCount freed memory tags, so oscillating around the memory tag boundary doesn't hit memory arena
+		void SetMaxSpareTagCount(int32 InMaxSpareTagCount) { MaxSpareTagCount = InMaxSpareTagCount; }
+		int32 GetSpareTagCount() const { return SpareTagCount; }
+
+		// statistics
+		//	- reused tag count is the count of memory tag creations avoided by spare memory tags
+		int64 GetCreatedTagCount() const { return CreatedTagCount; }
+		int64 GetReusedTagCount() const { return ReusedTagCount; }
+		int64 GetTrimmedTagCount() const { return TrimmedTagCount; }
+		int64 GetSpilledTagCount() const { return SpilledTagCount; }
+		int64 GetGrowInPlaceCount() const { return GrowInPlaceCount; }
+		int64 GetGrowCopyCount() const { return GrowCopyCount; }
+
+		enum
+		{
+			DEFAULT_MAX_SPARE_TAG_COUNT = 2,
+			// same as the alignment of global operator new
+			DEFAULT_ALIGNMENT = 16,
+			MAX_MARK_REPORT_COUNT = 32,
+		};
+
+#if !FINAL_RELEASE
+		// per-mark peak usage report
+		//	- only named memory marks are reported, the reports are keyed by the name (pointer)
+		struct H1MemMarkReport
+		{
+			const char* Name;
+			// the biggest usage while the memory mark was alive (including alignment padding)
+			uint64 PeakUsedSize;
+			int64 PopCount;
+		};
+
+		int32 GetMarkReportCount() const { return MarkReportCount; }
+		const H1MemMarkReport& GetMarkReport(int32 Index) const { return MarkReports[Index]; }
+		void ResetMarkReports() { MarkReportCount = 0; }
+		void DumpMarkReports() const;
+
+		// usage of the memory stack (including alignment padding)
+		uint64 GetUsedSize() const { return UsedSize; }
+		uint64 GetPeakUsedSize() const { return PeakUsedSize; }
+		// pushes which are not recorded for validation (over TRACK_STACK_ALLOC_CAPACITY)
+		int64 GetUntrackedAllocCount() const { return UntrackedAllocCount; }
+#endif
+
 	protected:
 		// friend class declaration
 		friend class H1MemMark;
@@ -34,11 +117,18 @@ namespace Memory
 		class MemoryTag;
 
 		// memory tag header
-		struct MemoryTagHeader
+		//	- aligned to DEFAULT_ALIGNMENT, so the start address of memory tag is already aligned
+		struct alignas(DEFAULT_ALIGNMENT) MemoryTagHeader
 		{		
 			// memory block data (real placeholder for MemoryTag)
 			H1MemoryBlock MemoryBlock;
 
+			// contiguous memory blocks for spilled memory tag (BaseAddress is nullptr for ordinary memory tag)
+			H1MemoryBlockRange MemoryBlockRange;
+
+			// usable size after the header (MemoryTag::DATA_SIZE for ordinary memory tag)
+			uint64 DataSize;
+
 			// memory tag indicator
 			MemoryTag* MemoryTag;
 
@@ -50,7 +140,8 @@ namespace Memory
 			byte* EndAddress;
 
 			// public methods
-			byte* GetStartAddress() { return &MemoryTag->Data[0]; }
+			byte* GetStartAddress() { return &MemoryTag->Layout.Data[0]; }
+			bool IsSpilled() const { return MemoryBlockRange.BaseAddress != nullptr; }
 		};
 
 		// memory tag in memory stack
@@ -110,6 +201,8 @@ namespace Memory
 
 				// update the value
 				Tag->Layout.Header.MemoryBlock = NewMemoryBlock;
+				Tag->Layout.Header.MemoryBlockRange = H1MemoryBlockRange(-1, -1, 0);
+				Tag->Layout.Header.DataSize = MemoryTag::DATA_SIZE;
 				Tag->Layout.Header.MemoryTag = Tag;
 				
 				if (Next == nullptr)
@@ -125,8 +218,36 @@ namespace Memory
 				return &(Tag->Layout.Header);
 			}
 
+			// spilled memory tag for the oversized push (Size includes alignment padding)
+			static MemoryTagHeader* CreateSpilledMemoryTag(uint64 Size, MemoryTagHeader* Next)
+			{
+				// create contiguous memory blocks which can hold the header and Size
+				int32 MemoryBlockCount = (int32)((MemoryTag::HEADER_SIZE + Size + H1MemoryArena::MEMORY_BLOCK_SIZE - 1) / H1MemoryArena::MEMORY_BLOCK_SIZE);
+				H1MemoryBlockRange NewMemoryBlocks = H1GlobalSingleton::MemoryArena()->AllocateMemoryBlocks(MemoryBlockCount);
+
+				// map memory tag to the beginning of new memory blocks
+				MemoryTag* Tag = (MemoryTag*)NewMemoryBlocks.BaseAddress;
+
+				Tag->Layout.Header.MemoryBlock = H1MemoryBlock(-1, -1);
+				Tag->Layout.Header.MemoryBlock.BaseAddress = NewMemoryBlocks.BaseAddress;
+				Tag->Layout.Header.MemoryBlockRange = NewMemoryBlocks;
+				Tag->Layout.Header.DataSize = (uint64)MemoryBlockCount * H1MemoryArena::MEMORY_BLOCK_SIZE - MemoryTag::HEADER_SIZE;
+				Tag->Layout.Header.MemoryTag = Tag;
+				Tag->Layout.Header.Next = Next;
+
+				return &(Tag->Layout.Header);
+			}
+
 			static void DestroyMemoryTag(MemoryTagHeader* Header)
 			{
+				if (Header->IsSpilled())
+				{
+					// destroy contiguous memory blocks (copy the range first, the header is in the memory blocks)
+					H1MemoryBlockRange MemoryBlocks = Header->MemoryBlockRange;
+					H1GlobalSingleton::MemoryArena()->DeallocateMemoryBlocks(MemoryBlocks);
+					return;
+				}
+
 				// destroy memory block
 				H1MemoryBlock MemoryBlock = Header->MemoryBlock;
 				H1GlobalSingleton::MemoryArena()->DeallocateMemoryBlock(MemoryBlock);
@@ -137,6 +258,54 @@ namespace Memory
 		//	- reaching to NewHead
 		void FreeMemoryTags(MemoryTagHeader* NewHead);
 
+		// create memory tag from spare memory tags first (or memory tag factory)
+		MemoryTagHeader* CreateMemoryTag(MemoryTagHeader* Next);
+		// keep the memory tag in spare memory tags (spilled memory tag is destroyed)
+		void ReleaseMemoryTag(MemoryTagHeader* Header);
+		// destroy spare memory tags except for the last RetainCount
+		void TrimSpareTags(int32 RetainCount);
+
+		// destructor registered for non-trivially destructible objects
+		struct H1StackDestructor
+		{
+			void (*Destruct)(void* Objects, uint64 Count);
+			void* Objects;
+			uint64 Count;
+			H1StackDestructor* Next;
+		};
+
+		template <class Type>
+		static void DestructObjects(void* Objects, uint64 Count)
+		{
+			// destruct in reverse order of construction
+			for (uint64 Index = Count; Index > 0; --Index)
+			{
+				((Type*)Objects)[Index - 1].~Type();
+			}
+		}
+
+		// trivially destructible, nothing to register
+		template <class Type>
+		void RegisterDestructor(Type* Objects, uint64 Count, std::true_type) {}
+
+		template <class Type>
+		void RegisterDestructor(Type* Objects, uint64 Count, std::false_type)
+		{
+			H1StackDestructor* Destructor = (H1StackDestructor*)Push(sizeof(H1StackDestructor), alignof(H1StackDestructor));
+			Destructor->Destruct = &DestructObjects<Type>;
+			Destructor->Objects = Objects;
+			Destructor->Count = Count;
+
+			// link to the head (the latest is run first)
+			Destructor->Next = DestructorHead;
+			DestructorHead = Destructor;
+		}
+
+		// run registered destructors reaching to NewHead
+		void RunDestructors(H1StackDestructor* NewHead);
+		// run registered destructors whose records are in [Address, CurrAddress) of current memory tag
+		void RunDestructorsAbove(byte* Address);
+
 		// member variables
 		// 1. memory tag header (Head)
 		MemoryTagHeader* Head;
@@ -145,27 +314,59 @@ namespace Memory
 		byte* CurrAddress;
 		// 3. memory marks
 		H1MemMark* MarkHead;
+		// 4. spare memory tags (the last freed is the head)
+		MemoryTagHeader* SpareHead;
+		int32 SpareTagCount;
+		int32 MaxSpareTagCount;
+		// 5. registered destructors
+		H1StackDestructor* DestructorHead;
+
+		// statistics
+		int64 CreatedTagCount;
+		int64 ReusedTagCount;
+		int64 TrimmedTagCount;
+		int64 SpilledTagCount;
+		int64 GrowInPlaceCount;
+		int64 GrowCopyCount;
 
 #if !FINAL_RELEASE
 		// tracking mem stack alloc
+		//	- records are kept as a stack in a memory block from memory arena (O(1) push and pop, no heap allocation per push)
+		//	- pushes over TRACK_STACK_ALLOC_CAPACITY only update the depth, they are not validated on pop
 		struct H1TrackStackAlloc
 		{
 			byte* StartAddress;
-			MemoryTagHeader* MemoryTag;
-
 			uint64 Size;
-			H1TrackStackAlloc* Next;
+			// Size and the alignment padding before StartAddress (counted in UsedSize)
+			uint64 ConsumedSize;
+		};
+
+		enum
+		{
+			TRACK_STACK_ALLOC_CAPACITY = H1MemoryArena::MEMORY_BLOCK_SIZE / sizeof(H1TrackStackAlloc),
 		};
 
-		H1TrackStackAlloc* TrackStackAllocHead;
+		H1MemoryBlock TrackStackAllocBlock;
+		H1TrackStackAlloc* TrackStackAllocs;
+		int64 TrackStackAllocDepth;
+		int64 UntrackedAllocCount;
+
+		uint64 UsedSize;
+		uint64 PeakUsedSize;
+
+		H1MemMarkReport MarkReports[MAX_MARK_REPORT_COUNT];
+		int32 MarkReportCount;
 
 		// methods
-		void CreateTrackStackAlloc(byte* StartAddress, uint64 Size);
+		void CreateTrackStackAlloc(byte* StartAddress, uint64 Size, uint64 ConsumedSize);
 		void ReleaseTrackStackAlloc(byte* StartAddress, uint64 Size);
-		void ReleaseCurrentHeadTrackStackAllocInternal();
+		// resize the top record (Grow/Shrink in place)
+		void ResizeTrackStackAlloc(byte* StartAddress, uint64 OldSize, uint64 NewSize);
+		void UpdatePeakUsedSize();
 
-		void ReleaseTackStackAllocByAddress(byte* EndAddress, MemoryTagHeader* MemoryTag);
-		void ReleaseTackStackAllocAll();
+		// release tracking records pushed after the memory mark
+		void ReleaseTrackStackAllocByMark(H1MemMark* Mark);
+		void RecordMarkReport(const char* Name, uint64 PeakUsedSize);
 #endif
 	};
 
@@ -173,12 +374,20 @@ namespace Memory
 	class H1MemMark
 	{
 	public:
-		H1MemMark(H1MemStack& Owner)
+		// Name is used for peak usage report in non-final build (it should be a string literal)
+		H1MemMark(H1MemStack& Owner, const char* InName = nullptr)
 			: OwnerStack(Owner)				
 		{
 			// get current memory tag and address
 			MarkedMemoryTag = OwnerStack.Head;
 			MarkedAddress = OwnerStack.CurrAddress;
+			MarkedDestructor = OwnerStack.DestructorHead;
+#if !FINAL_RELEASE
+			Name = InName;
+			MarkedTrackStackAllocDepth = OwnerStack.TrackStackAllocDepth;
+			MarkedUsedSize = OwnerStack.UsedSize;
+			PeakUsedSize = OwnerStack.UsedSize;
+#endif
 
 			// link the memory mark
 			Next = OwnerStack.MarkHead;
@@ -194,6 +403,11 @@ namespace Memory
 			OwnerStack.MarkHead = Next;
 		}			
 
+#if !FINAL_RELEASE
+		// the biggest usage pushed after the memory mark
+		uint64 GetPeakUsedSize() const { return PeakUsedSize - MarkedUsedSize; }
+#endif
+
 	protected:
 		// friend class declaration
 		friend class H1MemStack;
@@ -201,6 +415,9 @@ namespace Memory
 		// pop the memory stack reaching to the memmark
 		void Pop()
 		{
+			// run destructors first (the objects are still in the memory tags)
+			OwnerStack.RunDestructors(MarkedDestructor);
+
 			// free memory tags
 			OwnerStack.FreeMemoryTags(MarkedMemoryTag);
 
@@ -209,7 +426,7 @@ namespace Memory
 
 #if !FINAL_RELEASE
 			// remove debugging information for memory stack tracer
-			OwnerStack.ReleaseTackStackAllocByAddress(MarkedAddress, MarkedMemoryTag);
+			OwnerStack.ReleaseTrackStackAllocByMark(this);
 #endif
 		}
 
@@ -218,7 +435,17 @@ namespace Memory
 		// marked memory tag
 		H1MemStack::MemoryTagHeader* MarkedMemoryTag;
 		// marked base address from memory tag
-		byte* MarkedAddress;		
+		byte* MarkedAddress;
+		// marked destructor
+		H1MemStack::H1StackDestructor* MarkedDestructor;
+#if !FINAL_RELEASE
+		const char* Name;
+		// marked tracking depth and usage
+		int64 MarkedTrackStackAllocDepth;
+		uint64 MarkedUsedSize;
+		// the biggest usage of the owner stack while the memory mark is alive
+		uint64 PeakUsedSize;
+#endif
 		// linked list memory mark
 		H1MemMark* Next;
 	};
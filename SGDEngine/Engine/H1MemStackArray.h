@@ -0,0 +1,158 @@
+#pragma once
+
+#include "H1MemStack.h"
+
+namespace SGD
+{
+namespace Memory
+{
+	/*
+		H1MemStackArray
+			- dynamic array whose elements live in H1MemStack (scratch array which outgrows its first guess)
+			- growing resizes the allocation in place when it is still on top of the memory stack, otherwise elements are relocated to new allocation
+			- the memory is released by H1MemMark (it is returned at destruction only when the array is still on top)
+	*/
+	template <class Type>
+	class H1MemStackArray
+	{
+	public:
+		enum
+		{
+			DEFAULT_CAPACITY = 16,
+		};
+
+		H1MemStackArray(H1MemStack& InMemStack, uint64 InitialCapacity = DEFAULT_CAPACITY)
+			: MemStack(InMemStack)
+			, Data(nullptr)
+			, Count(0)
+			, Capacity(0)
+		{
+			Reserve(InitialCapacity);
+		}
+
+		~H1MemStackArray()
+		{
+			Clear();
+
+			// popped when the array is still on top
+			if (Data != nullptr)
+			{
+				MemStack.Shrink(Data, Capacity * sizeof(Type), 0);
+			}
+		}
+
+		// not copyable (the memory is owned by the memory stack)
+		H1MemStackArray(const H1MemStackArray&) = delete;
+		H1MemStackArray& operator=(const H1MemStackArray&) = delete;
+
+		template <class... ArgTypes>
+		Type& Emplace(ArgTypes&&... Args)
+		{
+			if (Count == Capacity)
+			{
+				Reserve(Capacity == 0 ? DEFAULT_CAPACITY : Capacity * 2);
+			}
+
+			Type* NewElement = new (&Data[Count]) Type(std::forward<ArgTypes>(Args)...);
+			Count++;
+
+			return *NewElement;
+		}
+
+		Type& Add(const Type& Value) { return Emplace(Value); }
+		Type& Add(Type&& Value) { return Emplace(SGD::move(Value)); }
+
+		void RemoveLast()
+		{
+			Count--;
+			Data[Count].~Type();
+		}
+
+		// destroy all elements (the capacity is kept)
+		void Clear()
+		{
+			while (Count > 0)
+			{
+				RemoveLast();
+			}
+		}
+
+		void Reserve(uint64 NewCapacity)
+		{
+			if (NewCapacity <= Capacity)
+			{
+				return;
+			}
+
+			if (Data == nullptr)
+			{
+				Data = (Type*)MemStack.Push(NewCapacity * sizeof(Type), alignof(Type));
+			}
+			else
+			{
+				Relocate(NewCapacity, SGD::is_trivially_copyable<Type>());
+			}
+
+			Capacity = NewCapacity;
+		}
+
+		// return unused capacity to the memory stack (only when the array is on top)
+		void ShrinkToFit()
+		{
+			if (Data != nullptr && Count < Capacity && MemStack.Shrink(Data, Capacity * sizeof(Type), Count * sizeof(Type)))
+			{
+				Capacity = Count;
+
+				// shrinking to zero pops the allocation, next Reserve pushes new one
+				if (Capacity == 0)
+				{
+					Data = nullptr;
+				}
+			}
+		}
+
+		Type& operator[](uint64 Index) { return Data[Index]; }
+		const Type& operator[](uint64 Index) const { return Data[Index]; }
+
+		uint64 Num() const { return Count; }
+		uint64 GetCapacity() const { return Capacity; }
+		Type* GetData() { return Data; }
+
+		Type* begin() { return Data; }
+		Type* end() { return Data + Count; }
+		const Type* begin() const { return Data; }
+		const Type* end() const { return Data + Count; }
+
+	protected:
+		// trivially copyable elements are copied by H1MemStack::Grow
+		void Relocate(uint64 NewCapacity, std::true_type)
+		{
+			Data = (Type*)MemStack.Grow(Data, Capacity * sizeof(Type), NewCapacity * sizeof(Type), alignof(Type));
+		}
+
+		// others are moved into new allocation when they can't grow in place
+		void Relocate(uint64 NewCapacity, std::false_type)
+		{
+			if (MemStack.TryGrowInPlace(Data, Capacity * sizeof(Type), NewCapacity * sizeof(Type)))
+			{
+				return;
+			}
+
+			Type* NewData = (Type*)MemStack.Push(NewCapacity * sizeof(Type), alignof(Type));
+			for (uint64 Index = 0; Index < Count; ++Index)
+			{
+				new (&NewData[Index]) Type(SGD::move(Data[Index]));
+				Data[Index].~Type();
+			}
+
+			Data = NewData;
+		}
+
+		H1MemStack& MemStack;
+
+		Type* Data;
+		uint64 Count;
+		uint64 Capacity;
+	};
+}
+}
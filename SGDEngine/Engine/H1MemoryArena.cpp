@@ -7,96 +7,166 @@ using namespace SGD::Memory;
 #include "H1PlatformUtil.h"
 using namespace SGD::Platform::Util;
 
-H1MemoryArena::MemoryPage::AllocOutput H1MemoryArena::AllocateInternal(const MemoryPage::AllocInput& Input)
+H1MemoryArena::MemoryPage* H1MemoryArena::TryAllocateFromPages(const MemoryPage::AllocInput& Input, int32 NumaNode, MemoryPage::AllocOutput& Output)
 {
-	// synchronized allocation
-	SGD::Thread::H1ScopeLock ScopeLock(&MemoryArenaSyncObject);
-
-	// alloc output
-	MemoryPage::AllocOutput Output;
+	// retired page table entry is not reused while looping
+	PageWalkScope WalkScope(this);
 
 	// looping current page, and try to allocate page
-	MemoryPage* CurrPage = FreePageHead;
+	MemoryPage* CurrPage = SubArenas[Input.Tag].PageHeads[NumaNode].load(std::memory_order_acquire);
 	while (CurrPage != nullptr)
 	{
-		Output = CurrPage->Allocate(Input);
-		if (Output.Offset != -1)
+		// skip the page which doesn't have long enough free run
+		if (CurrPage->CanAllocate(Input.BlockCount))
 		{
-			// successfully allocate block
-			break;
+			Output = CurrPage->Allocate(Input);
+			if (Output.Offset != -1)
+			{
+				// successfully allocate block
+				return CurrPage;
+			}
 		}
 
 		// move to next page
 		CurrPage = CurrPage->GetNextPage();
 	}
 
+	return nullptr;
+}
+
+H1MemoryArena::MemoryPage::AllocOutput H1MemoryArena::AllocateInternal(const MemoryPage::AllocInput& Input)
+{
+	// alloc output
+	MemoryPage::AllocOutput Output;
+
+	// lock-free allocation from existing pages of the requested NUMA node
+	MemoryPage* CurrPage = TryAllocateFromPages(Input, Input.NumaNode, Output);
+
+	// fallback to other NUMA nodes' pages
+	if (CurrPage == nullptr && bNumaRemoteFallback)
+	{
+		for (int32 NumaNode = 0; NumaNode < NumaNodeCount && CurrPage == nullptr; ++NumaNode)
+		{
+			if (NumaNode != Input.NumaNode)
+			{
+				CurrPage = TryAllocateFromPages(Input, NumaNode, Output);
+			}
+		}
+
+		if (CurrPage != nullptr)
+		{
+			NumaRemoteAllocCount++;
+		}
+	}
+
 	// check whether the block is allocated
-	if (Output.Offset == -1)
+	if (CurrPage == nullptr)
 	{
-		// allocate new page
-		MemoryPage* NewPage = AllocatePage();
+		// synchronized page creation (per sub-arena)
+		SubArena& CurrSubArena = SubArenas[Input.Tag];
+		LockSyncObject(CurrSubArena.SyncObject);
+
+		// other thread could create new page while waiting the lock
+		CurrPage = TryAllocateFromPages(Input, Input.NumaNode, Output);
+		if (CurrPage == nullptr)
+		{
+			// allocate new page
+			CurrPage = AllocatePage(Input.NumaNode, Input.Tag);
+
+			// allocate new output
+			Output = CurrPage->Allocate(Input);
+			h1MemCheck(Output.Offset != -1, "Error! please check this");
+		}
+
+		CurrSubArena.SyncObject.UnLock();
+	}
+
+	RecordPageAlloc(Output.Count);
 
-		// allocate new output
-		Output = NewPage->Allocate(Input);
-		h1MemCheck(Output.Offset != -1, "Error! please check this");
+	// lazily commit memory blocks which are handed out
+	if (IsVirtualMemoryBacked())
+	{
+		CommitMemoryBlocks(CurrPage, Output.Offset, Output.Count);
 	}
 
 	return Output;
 }
 
-void H1MemoryArena::DeallocateInternal(const MemoryPage::DeallocInput& Input)
+void H1MemoryArena::DeallocateInternal(MemoryPage::DeallocInput& Input)
 {
-	// synchronized deallocation
-	SGD::Thread::H1ScopeLock ScopeLock(&MemoryArenaSyncObject);
+	// look up the memory page by address (it doesn't need any lock)
+	MemoryPage* CurrPage = PageDirectory.Find(Input.BaseAddress);
+	h1MemCheck(CurrPage != nullptr, "failed to find memory page, please check!");
 
-	// looping naive memory pages
-	MemoryPage* CurrPage = PageHead.get();
-	while (CurrPage != nullptr)
-	{
-		// check whether the current page match tag id
-		if (CurrPage->Layout.TagId == Input.TagId)
-		{
-			CurrPage->Deallocate(Input);
-			break;
-		}
+	// resolve the block offset and count from the address
+	int32 Offset = CurrPage->GetBlockOffset(Input.BaseAddress);
+	h1MemCheck(Input.Offset == -1 || Input.Offset == Offset, "invalid memory block offset, please check!");
+	h1MemCheck(Input.TagId == (uint32)-1 || Input.TagId == CurrPage->Layout.TagId, "invalid memory page tag id, please check!");
 
-		// move to next page
-		CurrPage = CurrPage->GetNextPage();
+	Input.TagId = CurrPage->Layout.TagId;
+	Input.Offset = Offset;
+	Input.Tag = CurrPage->Layout.Tag;
+	if (Input.Count == -1)
+	{
+		Input.Count = CurrPage->Layout.Headers[Offset].BlockCount;
 	}
 
-	h1MemCheck(CurrPage != nullptr, "failed to find memory page, please check!");
+	// lock-free deallocation
+	CurrPage->Deallocate(Input);
+	PageBlockInUseCount -= Input.Count;
+
+	// deallocated memory blocks stay committed until they are purged
+	if (IsVirtualMemoryBacked())
+	{
+		FreeCommittedSize += (int64)Input.Count * MEMORY_BLOCK_SIZE;
+	}
+}
 
-	// looping free memory page and if curr page is not available, insert it
-	MemoryPage* CurrFreePage = FreePageHead;
-	while (CurrFreePage != nullptr)
+H1MemoryBlock H1MemoryArena::AllocateMemoryBlock(MemoryTag InTag)
+{
+	// try thread-local magazine first (only for default tag)
+	BlockMagazineCache* Cache = (InTag == MemoryTag_Default) ? GetMagazineCache() : nullptr;
+	if (Cache != nullptr)
 	{
-		if (CurrFreePage->Layout.TagId == CurrPage->Layout.TagId)
+		if (!ReserveTagBudget(InTag, MEMORY_BLOCK_SIZE))
 		{
-			// it is already exists in free page
-			break;
+			return H1MemoryBlock(-1, -1);
 		}
 
-		// move to next free page
-		CurrFreePage = CurrFreePage->GetNextFreePage();
+		RecordAlloc(1);
+		return CreateMemoryBlock(AllocateFromMagazine(Cache));
 	}
 
-	// add curr free page list (link it properly)
-	if (CurrFreePage == nullptr)
-	{
-		CurrPage->SetNextFreePage(FreePageHead);
-		FreePageHead = CurrPage;
-	}
+	return AllocateMemoryBlockOnNode(GetPreferredNumaNode(), InTag);
+}
+
+H1MemoryBlockRange H1MemoryArena::AllocateMemoryBlocks(int32 MemoryBlockCount, MemoryTag InTag)
+{
+	return AllocateMemoryBlocksOnNode(MemoryBlockCount, GetPreferredNumaNode(), InTag);
 }
 
-H1MemoryBlock H1MemoryArena::AllocateMemoryBlock()
+H1MemoryBlock H1MemoryArena::AllocateMemoryBlockOnNode(int32 NumaNode, MemoryTag InTag)
 {
+	h1MemCheck(NumaNode >= 0 && NumaNode < NumaNodeCount, "invalid NUMA node, please check!");
+	h1MemCheck(InTag >= 0 && InTag < MemoryTag_Count, "invalid memory tag, please check!");
+
+	if (!ReserveTagBudget(InTag, MEMORY_BLOCK_SIZE))
+	{
+		return H1MemoryBlock(-1, -1);
+	}
+
 	// create the alloc input
 	MemoryPage::AllocInput Input;
 	Input.BlockCount = 1;
+	Input.NumaNode = NumaNode;
+	Input.Tag = InTag;
+	Input.Placement = Placement;
 
 	// alloc output
 	MemoryPage::AllocOutput Output = AllocateInternal(Input);
 
+	RecordAlloc(1);
+
 	// successfully create memory block
 	H1MemoryBlock NewBlock(Output.TagId, Output.Offset);
 	NewBlock.BaseAddress = Output.BaseAddress;
@@ -105,15 +175,46 @@ H1MemoryBlock H1MemoryArena::AllocateMemoryBlock()
 	return NewBlock;
 }
 
-H1MemoryBlockRange H1MemoryArena::AllocateMemoryBlocks(int32 MemoryBlockCount)
+H1MemoryBlockRange H1MemoryArena::AllocateMemoryBlocksOnNode(int32 MemoryBlockCount, int32 NumaNode, MemoryTag InTag)
 {
+	h1MemCheck(NumaNode >= 0 && NumaNode < NumaNodeCount, "invalid NUMA node, please check!");
+	h1MemCheck(InTag >= 0 && InTag < MemoryTag_Count, "invalid memory tag, please check!");
+
+	// memory page can't serve it, redirect to large block
+	if (MemoryBlockCount > MemoryPage::MEMORY_BLOCK_COUNT)
+	{
+		H1MemoryLargeBlock LargeBlock = AllocateLargeBlockInternal((int64)MemoryBlockCount * MEMORY_BLOCK_SIZE, NumaNode, InTag);
+		if (LargeBlock.BaseAddress == nullptr)
+		{
+			return H1MemoryBlockRange(-1, -1, -1);
+		}
+
+		H1MemoryBlockRange NewBlockRange(LARGE_BLOCK_PAGE_TAG_ID, LargeBlock.LargeBlockIndex, MemoryBlockCount);
+		NewBlockRange.BaseAddress = LargeBlock.BaseAddress;
+		NewBlockRange.Size = H1MemoryArena::MEMORY_BLOCK_SIZE * MemoryBlockCount;
+
+		RecordAlloc(MemoryBlockCount);
+
+		return NewBlockRange;
+	}
+
+	if (!ReserveTagBudget(InTag, (int64)MemoryBlockCount * MEMORY_BLOCK_SIZE))
+	{
+		return H1MemoryBlockRange(-1, -1, -1);
+	}
+
 	// create the alloc input
 	MemoryPage::AllocInput Input;
 	Input.BlockCount = MemoryBlockCount;
+	Input.NumaNode = NumaNode;
+	Input.Tag = InTag;
+	Input.Placement = Placement;
 
 	// alloc output
 	MemoryPage::AllocOutput Output = AllocateInternal(Input);
 
+	RecordAlloc(Output.Count);
+
 	// successfully create memory block
 	H1MemoryBlockRange NewBlockRange(Output.TagId, Output.Offset, Output.Count);
 	NewBlockRange.BaseAddress = Output.BaseAddress;
@@ -122,10 +223,113 @@ H1MemoryBlockRange H1MemoryArena::AllocateMemoryBlocks(int32 MemoryBlockCount)
 	return NewBlockRange;
 }
 
+int32 H1MemoryArena::GetMemoryBlockNumaNode(const void* Address) const
+{
+	MemoryPage* Page = PageDirectory.Find(Address);
+	return (Page != nullptr) ? Page->Layout.NumaNode : -1;
+}
+
+void H1MemoryArena::InitializeNumaNodes()
+{
+	// read node topology once
+	NumaNodeCount = appGetNumaNodeCount();
+	if (NumaNodeCount < 1)
+	{
+		NumaNodeCount = 1;
+	}
+	else if (NumaNodeCount > MAX_NUMA_NODE_COUNT)
+	{
+		NumaNodeCount = MAX_NUMA_NODE_COUNT;
+	}
+
+	for (int32 Tag = 0; Tag < MemoryTag_Count; ++Tag)
+	{
+		for (int32 NumaNode = 0; NumaNode < MAX_NUMA_NODE_COUNT; ++NumaNode)
+		{
+			SubArenas[Tag].PageHeads[NumaNode] = nullptr;
+		}
+	}
+}
+
+int32 H1MemoryArena::GetPreferredNumaNode() const
+{
+	// single node doesn't need to query current cpu
+	if (NumaNodeCount == 1)
+	{
+		return 0;
+	}
+
+	return appGetCurrentNumaNode() % NumaNodeCount;
+}
+
+bool H1MemoryArena::ReserveTagBudget(MemoryTag InTag, int64 Size)
+{
+	SubArena& CurrSubArena = SubArenas[InTag];
+	const TagBudget& Budget = CurrSubArena.Budget;
+
+	for (int32 TryCount = 0; ; ++TryCount)
+	{
+		int64 UsedSize = CurrSubArena.UsedSize.fetch_add(Size, std::memory_order_relaxed) + Size;
+		if (Budget.BudgetSize <= 0 || UsedSize <= Budget.BudgetSize)
+		{
+			return true;
+		}
+
+		// over budget; give it back while caches are evicting
+		CurrSubArena.UsedSize.fetch_sub(Size, std::memory_order_relaxed);
+		CurrSubArena.OverBudgetCount++;
+
+		bool bReleased = false;
+		if (Budget.Callback != nullptr && TryCount < MAX_OVER_BUDGET_RETRY_COUNT)
+		{
+			bReleased = Budget.Callback(this, InTag, Size, Budget.UserData);
+		}
+
+		if (bReleased)
+		{
+			// retry
+			continue;
+		}
+
+		if (!Budget.bHardBudget)
+		{
+			// soft budget; allocation goes over the budget
+			CurrSubArena.UsedSize.fetch_add(Size, std::memory_order_relaxed);
+			return true;
+		}
+
+		CurrSubArena.AllocFailCount++;
+		return false;
+	}
+}
+
+void H1MemoryArena::ReleaseTagBudget(MemoryTag InTag, int64 Size)
+{
+	SubArenas[InTag].UsedSize.fetch_sub(Size, std::memory_order_relaxed);
+}
+
 void H1MemoryArena::DeallocateMemoryBlock(const H1MemoryBlock& InMemoryBlock)
 {
+	RecordFree(1);
+
+	// memory tag is resolved by the page
+	MemoryPage* Page = PageDirectory.Find(InMemoryBlock.BaseAddress);
+	h1MemCheck(Page != nullptr, "failed to find memory page, please check!");
+
+	MemoryTag Tag = Page->Layout.Tag;
+	ReleaseTagBudget(Tag, MEMORY_BLOCK_SIZE);
+
+	// return it to thread-local magazine
+	BlockMagazineCache* Cache = (Tag == MemoryTag_Default) ? GetMagazineCache() : nullptr;
+	if (Cache != nullptr)
+	{
+		DeallocateToMagazine(Cache, InMemoryBlock.BaseAddress);
+		return;
+	}
+
 	// create the dealloc input
 	MemoryPage::DeallocInput Input;
+	Input.BaseAddress = InMemoryBlock.BaseAddress;
 	Input.TagId = InMemoryBlock.PageTagId;
 	Input.Offset = InMemoryBlock.Offset;
 	Input.Count = 1;
@@ -136,181 +340,2044 @@ void H1MemoryArena::DeallocateMemoryBlock(const H1MemoryBlock& InMemoryBlock)
 
 void H1MemoryArena::DeallocateMemoryBlocks(const H1MemoryBlockRange& InMemoryBlocks)
 {
+	RecordFree(InMemoryBlocks.Count);
+
+	// memory block range redirected to large block
+	if (InMemoryBlocks.PageTagId == LARGE_BLOCK_PAGE_TAG_ID)
+	{
+		DeallocateLargeBlockInternal(InMemoryBlocks.Offset);
+		return;
+	}
+
 	// create the dealloc input
 	MemoryPage::DeallocInput Input;
+	Input.BaseAddress = InMemoryBlocks.BaseAddress;
 	Input.TagId = InMemoryBlocks.PageTagId;
 	Input.Offset = InMemoryBlocks.Offset;
 	Input.Count = InMemoryBlocks.Count;
 
 	// deallocate it
 	DeallocateInternal(Input);
+	ReleaseTagBudget(Input.Tag, (int64)Input.Count * MEMORY_BLOCK_SIZE);
 }
 
-H1MemoryArena::MemoryPage* H1MemoryArena::AllocatePage()
+void H1MemoryArena::DeallocateByAddress(void* Address)
 {
-	// create new page
-	SGD::unique_ptr<MemoryPage> NewPage = SGD::make_unique<MemoryPage>();
-	// reset the page
-	SGD::Platform::Util::appMemzero((byte*)NewPage.get(), sizeof(MemoryPage));
+	MemoryPage* Page = PageDirectory.Find(Address);
+	if (Page == nullptr)
+	{
+		// not in memory pages, it should be large block
+		int32 LargeBlockIndex = FindLargeBlockIndex(Address);
+		h1MemCheck(LargeBlockIndex != -1, "failed to find memory page, please check!");
 
-	// properly link new page
-	NewPage->SetNextPage(PageHead);
+		RecordFree(DeallocateLargeBlockInternal(LargeBlockIndex) / MEMORY_BLOCK_SIZE);
+		return;
+	}
 
-	// properly link new free page
-	NewPage->SetNextFreePage(FreePageHead);
-	FreePageHead = SGD::move(NewPage.get());
+	// single memory block of default tag is returned to thread-local magazine
+	BlockMagazineCache* Cache = (Page->Layout.Tag == MemoryTag_Default) ? GetMagazineCache() : nullptr;
+	if (Cache != nullptr)
+	{
+		if (Page->Layout.Headers[Page->GetBlockOffset(Address)].BlockCount == 1)
+		{
+			RecordFree(1);
+			ReleaseTagBudget(MemoryTag_Default, MEMORY_BLOCK_SIZE);
+			DeallocateToMagazine(Cache, (byte*)Address);
+			return;
+		}
+	}
 
-	// lastly move the new page to page head (this is because after eastl::move, NewPage become nullptr)
-	PageHead = SGD::move(NewPage);	
+	// offset and count are resolved by page directory and memory header
+	MemoryPage::DeallocInput Input;
+	Input.BaseAddress = (byte*)Address;
 
-	return PageHead.get();
+	// deallocate it
+	DeallocateInternal(Input);
+	RecordFree(Input.Count);
+	ReleaseTagBudget(Input.Tag, (int64)Input.Count * MEMORY_BLOCK_SIZE);
 }
 
-void H1MemoryArena::DeallocateAllPages()
+H1MemoryArena::BlockPageType H1MemoryArena::GetMemoryBlockPageType(const void* Address) const
 {
-	// looping all free page node
-	while (FreePageHead != nullptr)
+	MemoryPage* Page = PageDirectory.Find(Address);
+	if (Page == nullptr)
 	{
-		// move to next free page (implicitly invalidate free page pointer)
-		FreePageHead = FreePageHead->Layout.NextFreePage;
+		return BlockPage_NotCommitted;
 	}
 
-	// looping all pages
-	while (PageHead.get() == nullptr)
+	// heap backed page is committed as a whole
+	if (!IsVirtualMemoryBacked())
 	{
-		// get the unique
-		SGD::unique_ptr<MemoryPage> TempPageHead = SGD::move(PageHead);
+		return BlockPage_Regular;
+	}
 
-		// move next page
-		PageHead = SGD::move(TempPageHead.get()->Layout.NextPage);
+	return Page->GetBlockPageType(Page->GetBlockOffset(Address));
+}
 
-		// release the previous page head
-		TempPageHead.reset();
-	}
+H1MemoryLargeBlock H1MemoryArena::AllocateLargeBlock(int64 Size, MemoryTag InTag)
+{
+	return AllocateLargeBlockInternal(Size, GetPreferredNumaNode(), InTag);
 }
 
-H1MemoryArena::MemoryPage::AllocOutput H1MemoryArena::MemoryPage::Allocate(const AllocInput& Params)
+H1MemoryLargeBlock H1MemoryArena::AllocateLargeBlockInternal(int64 Size, int32 NumaNode, MemoryTag InTag)
 {
-	AllocOutput Output;
-	Output.TagId = Layout.TagId;
-	Output.Offset = -1;
-	Output.Count = 0;
+	h1MemCheck(Size > 0, "invalid large block size, please check!");
+	h1MemCheck(InTag >= 0 && InTag < MemoryTag_Count, "invalid memory tag, please check!");
 
-	// get the available block index
-	int32 Offset = GetAvailableBlockIndex(Params.BlockCount);
-	if (Offset != -1)
+	int64 MappedSize = Align(Size, MEMORY_BLOCK_SIZE);
+	if (!ReserveTagBudget(InTag, MappedSize))
 	{
-		// mark alloc bit
-		MarkAllocBits(true, Offset, Params.BlockCount);
-
-		// update output results
-		Output.Offset = Offset;
-		Output.Count = Params.BlockCount;
+		return H1MemoryLargeBlock(-1);
 	}
 
-	// set base address
-	Output.BaseAddress = (byte*)&Layout.MemoryBlocks[Output.Offset];
+	byte* BaseAddress = MapLargeBlock(MappedSize, NumaNode);
 
-	return Output;
-}
+	// take the table entry
+	int32 LargeBlockIndex = -1;
+	{
+		SGD::Thread::H1ScopeLock ScopeLock(&LargeBlockSyncObject);
 
-void H1MemoryArena::MemoryPage::Deallocate(const DeallocInput& Params)
-{
-#if !FINAL_RELEASE
-	// validation check
-	ValidateAllocBits(true, Params.Offset, Params.Count);
-#endif
+		if (LargeBlockFreeHead != -1)
+		{
+			LargeBlockIndex = LargeBlockFreeHead;
+			LargeBlockFreeHead = LargeBlocks[LargeBlockIndex].NextFreeIndex;
+		}
+		else
+		{
+			h1MemCheck(LargeBlockUsedCount < MAX_LARGE_BLOCK_COUNT, "too many large blocks, please check!");
+			LargeBlockIndex = LargeBlockUsedCount++;
+		}
 
-	// just mark as free
-	MarkAllocBits(false, Params.Offset, Params.Count);
+		LargeBlockEntry& Entry = LargeBlocks[LargeBlockIndex];
+		Entry.BaseAddress = BaseAddress;
+		Entry.MappedSize = MappedSize;
+		Entry.NextFreeIndex = -1;
+		Entry.Tag = InTag;
+	}
+
+	LargeBlockCount++;
+	LargeBlockSize += MappedSize;
+	LargeAllocCount++;
+
+	H1MemoryLargeBlock NewLargeBlock(LargeBlockIndex);
+	NewLargeBlock.BaseAddress = BaseAddress;
+	NewLargeBlock.Size = Size;
+
+	return NewLargeBlock;
 }
 
-int32 H1MemoryArena::MemoryPage::GetAvailableBlockIndex(int32 InBlockCount)
+bool H1MemoryArena::ReallocateLargeBlock(H1MemoryLargeBlock& InOutLargeBlock, int64 NewSize)
 {
-	int32 Offset = -1;
+	h1MemCheck(NewSize > 0, "invalid large block size, please check!");
+	h1MemCheck(InOutLargeBlock.LargeBlockIndex >= 0 && InOutLargeBlock.LargeBlockIndex < LargeBlockUsedCount, "invalid large block index, please check!");
 
-	// copy the bit alloc flag
-	uint64 AllocMask = ~(Layout.AllocBitMask); // change bit opposite (to use BitScanForward)
-	// copy the block count
-	int64 BlockCount = static_cast<int64>(InBlockCount);
+	// the large block itself is owned by the caller, the lock is only for the table
+	LargeBlockEntry Entry;
+	{
+		SGD::Thread::H1ScopeLock ScopeLock(&LargeBlockSyncObject);
+		Entry = LargeBlocks[InOutLargeBlock.LargeBlockIndex];
+	}
+	h1MemCheck(Entry.BaseAddress == InOutLargeBlock.BaseAddress, "invalid large block, please check!");
 
-	// if the block count becomes zero, it found the offset
-	uint64 StartOffset = -1;
-	uint64 CurrOffset = 0;
-	while (BlockCount > 0)
+	int64 NewMappedSize = Align(NewSize, MEMORY_BLOCK_SIZE);
+	if (NewMappedSize != Entry.MappedSize)
 	{
-		// first find the nonzero bit		
-		if (!appBitScanForward64(CurrOffset, AllocMask))
+		// growing large block takes more budget of its tag
+		if (NewMappedSize > Entry.MappedSize && !ReserveTagBudget(Entry.Tag, NewMappedSize - Entry.MappedSize))
 		{
-			// just break the loop and return it
-			break;
+			return false;
 		}
-
-		if (CurrOffset + BlockCount > MEMORY_BLOCK_COUNT) // if it reach to the end, break the loop
+		else if (NewMappedSize < Entry.MappedSize)
 		{
-			break;
+			ReleaseTagBudget(Entry.Tag, Entry.MappedSize - NewMappedSize);
 		}
 
-		// update start offset
-		StartOffset = CurrOffset;
-
-		// test and set it as allocated (as bit 1)		
-		while (BlockCount > 0)
+		// remap physical pages first (it keeps NUMA policy and huge page advice of the mapping)
+		//	- moved address is only aligned to OS page size
+		byte* NewAddress = appRemapVirtualMemory(Entry.BaseAddress, Entry.MappedSize, NewMappedSize);
+		if (NewAddress != nullptr)
 		{
-			// test bit and set it as allocated
-			if (appBitTestAndReset64(CurrOffset, AllocMask))
-			{
-				CurrOffset++;
-				BlockCount--;
-			}
-			else
-			{
-				// reset the block count and stop looping
-				BlockCount = InBlockCount;
-				break;
-			}
+			LargeRemapCount++;
+		}
+		else
+		{
+			// map new region and copy it
+			NewAddress = MapLargeBlock(NewMappedSize, GetPreferredNumaNode());
+			appMemcpy(Entry.BaseAddress, NewAddress, (InOutLargeBlock.Size < NewSize) ? InOutLargeBlock.Size : NewSize);
+			UnmapLargeBlock(Entry.BaseAddress, Entry.MappedSize);
+
+			LargeCopyCount++;
 		}
+
+		LargeBlockSize += NewMappedSize - Entry.MappedSize;
+
+		SGD::Thread::H1ScopeLock ScopeLock(&LargeBlockSyncObject);
+		LargeBlocks[InOutLargeBlock.LargeBlockIndex].BaseAddress = NewAddress;
+		LargeBlocks[InOutLargeBlock.LargeBlockIndex].MappedSize = NewMappedSize;
+
+		InOutLargeBlock.BaseAddress = NewAddress;
 	}
 
-	// if the block count reach to 0, update the offset
-	if (BlockCount == 0)
+	InOutLargeBlock.Size = NewSize;
+
+	return true;
+}
+
+void H1MemoryArena::DeallocateLargeBlock(const H1MemoryLargeBlock& InLargeBlock)
+{
+	h1MemCheck(InLargeBlock.LargeBlockIndex >= 0 && InLargeBlock.LargeBlockIndex < LargeBlockUsedCount, "invalid large block index, please check!");
+	h1MemCheck(LargeBlocks[InLargeBlock.LargeBlockIndex].BaseAddress == InLargeBlock.BaseAddress, "invalid large block, please check!");
+
+	DeallocateLargeBlockInternal(InLargeBlock.LargeBlockIndex);
+}
+
+int64 H1MemoryArena::DeallocateLargeBlockInternal(int32 LargeBlockIndex)
+{
+	byte* BaseAddress = nullptr;
+	int64 MappedSize = 0;
+	MemoryTag Tag = MemoryTag_Default;
+
+	// return the table entry
 	{
-		h1MemCheck(StartOffset < 65, "offset should not be bigger than 64 please check!");
-		Offset = (int32)StartOffset;
+		SGD::Thread::H1ScopeLock ScopeLock(&LargeBlockSyncObject);
+
+		LargeBlockEntry& Entry = LargeBlocks[LargeBlockIndex];
+		h1MemCheck(Entry.BaseAddress != nullptr, "large block is already deallocated, please check!");
+
+		BaseAddress = Entry.BaseAddress;
+		MappedSize = Entry.MappedSize;
+		Tag = Entry.Tag;
+
+		Entry.BaseAddress = nullptr;
+		Entry.MappedSize = 0;
+		Entry.NextFreeIndex = LargeBlockFreeHead;
+		LargeBlockFreeHead = LargeBlockIndex;
 	}
 
-	return Offset;
+	// unmap it outside of the lock
+	UnmapLargeBlock(BaseAddress, MappedSize);
+	ReleaseTagBudget(Tag, MappedSize);
+
+	LargeBlockCount--;
+	LargeBlockSize -= MappedSize;
+
+	return MappedSize;
 }
 
-void H1MemoryArena::MemoryPage::MarkAllocBits(bool InValue, int32 InOffset, int32 InCount)
+int32 H1MemoryArena::FindLargeBlockIndex(const void* Address)
 {
-	// InValue is same, so we don't need to worry about inner branch prediction (for performance issue)
-	for (int32 CurrOffset = InOffset; CurrOffset < InCount; ++CurrOffset)
+	// only for deallocation without the handle, large blocks are few enough to loop them
+	SGD::Thread::H1ScopeLock ScopeLock(&LargeBlockSyncObject);
+
+	for (int32 LargeBlockIndex = 0; LargeBlockIndex < LargeBlockUsedCount; ++LargeBlockIndex)
 	{
-		if (InValue) // mark it as allocated
+		if (LargeBlocks[LargeBlockIndex].BaseAddress == Address)
 		{
-			Layout.AllocBitMask |= (1ll << CurrOffset);
+			return LargeBlockIndex;
 		}
-		else // mark it as free (deallocated)
+	}
+
+	return -1;
+}
+
+byte* H1MemoryArena::MapLargeBlock(int64 MappedSize, int32 NumaNode)
+{
+	// large block is always mapped from virtual memory regardless of backing type (to be remapped later)
+	//	- aligned to MEMORY_BLOCK_SIZE (same as huge page size)
+	byte* Address = appReserveAlignedVirtualMemory(MappedSize, MEMORY_BLOCK_SIZE);
+	h1MemCheck(Address != nullptr, "failed to reserve virtual memory for large block");
+
+	if (NumaNodeCount > 1)
+	{
+		appBindVirtualMemoryToNumaNode(Address, MappedSize, NumaNode);
+	}
+
+	// commit as a whole, physical memory is backed on first touch
+	bool bCommitted = appCommitVirtualMemory(Address, MappedSize);
+	h1MemCheck(bCommitted, "failed to commit large block");
+
+	if (Backing == HugePage)
+	{
+		appAdviseHugePage(Address, MappedSize);
+	}
+
+	return Address;
+}
+
+void H1MemoryArena::UnmapLargeBlock(byte* Address, int64 MappedSize)
+{
+	appReleaseVirtualMemory(Address, MappedSize);
+}
+
+void H1MemoryArena::DeallocateAllLargeBlocks()
+{
+	for (int32 LargeBlockIndex = 0; LargeBlockIndex < LargeBlockUsedCount; ++LargeBlockIndex)
+	{
+		LargeBlockEntry& Entry = LargeBlocks[LargeBlockIndex];
+		if (Entry.BaseAddress != nullptr)
 		{
-			Layout.AllocBitMask &= ~(1ll << CurrOffset);
+			UnmapLargeBlock(Entry.BaseAddress, Entry.MappedSize);
 		}
 	}
+
+	LargeBlockFreeHead = -1;
+	LargeBlockUsedCount = 0;
+	LargeBlockCount = 0;
+	LargeBlockSize = 0;
 }
 
-void H1MemoryArena::MemoryPage::ValidateAllocBits(bool InValue, int32 InOffset, int32 InCount)
+H1MemoryArena::ThreadStats& H1MemoryArena::GetThreadStats()
+{
+	// unique index for each thread (shared by all memory arenas)
+	static SGD::atomic<int32> NextThreadStatsIndex(0);
+	static thread_local int32 ThreadStatsIndex = NextThreadStatsIndex.fetch_add(1) % MAX_THREAD_STATS_COUNT;
+
+	return ThreadStatsSlots[ThreadStatsIndex];
+}
+
+void H1MemoryArena::RecordAlloc(int64 BlockCount)
+{
+	// the slot is mostly owned by one thread, relaxed add is uncontended
+	ThreadStats& Stats = GetThreadStats();
+	Stats.AllocCount.fetch_add(1, std::memory_order_relaxed);
+	Stats.AllocBlockCount.fetch_add(BlockCount, std::memory_order_relaxed);
+}
+
+void H1MemoryArena::RecordFree(int64 BlockCount, int64 FreeCount)
+{
+	ThreadStats& Stats = GetThreadStats();
+	Stats.FreeCount.fetch_add(FreeCount, std::memory_order_relaxed);
+	Stats.FreeBlockCount.fetch_add(BlockCount, std::memory_order_relaxed);
+}
+
+void H1MemoryArena::RecordPageAlloc(int64 BlockCount)
+{
+	// page level allocation already does atomic operation on shared alloc bit mask, and single memory blocks are mostly served by magazines
+	int64 InUseCount = PageBlockInUseCount.fetch_add(BlockCount, std::memory_order_relaxed) + BlockCount;
+
+	int64 PeakCount = PeakPageBlockInUseCount.load(std::memory_order_relaxed);
+	while (InUseCount > PeakCount && !PeakPageBlockInUseCount.compare_exchange_weak(PeakCount, InUseCount, std::memory_order_relaxed))
+	{
+	}
+}
+
+void H1MemoryArena::LockSyncObject(SGD::Thread::H1CriticalSection& SyncObject)
+{
+	ThreadStats& Stats = GetThreadStats();
+	Stats.LockCount.fetch_add(1, std::memory_order_relaxed);
+
+	// only measure the time when the lock is contended
+	if (!SyncObject.TryLock())
+	{
+		uint64 StartTime = appGetTimeNanoseconds();
+		SyncObject.Lock();
+
+		Stats.LockContendedCount.fetch_add(1, std::memory_order_relaxed);
+		Stats.LockSpinNanoseconds.fetch_add((int64)(appGetTimeNanoseconds() - StartTime), std::memory_order_relaxed);
+	}
+}
+
+void H1MemoryArena::GetStats(ArenaStats& OutStats)
 {
-	for (int32 CurrOffset = InOffset; CurrOffset < InCount; ++CurrOffset)
+	SGD::Platform::Util::appMemzero((byte*)&OutStats, sizeof(ArenaStats));
+
+	// aggregate per-thread counters
+	for (int32 SlotIndex = 0; SlotIndex < MAX_THREAD_STATS_COUNT; ++SlotIndex)
+	{
+		const ThreadStats& Stats = ThreadStatsSlots[SlotIndex];
+		OutStats.AllocCount += Stats.AllocCount.load(std::memory_order_relaxed);
+		OutStats.FreeCount += Stats.FreeCount.load(std::memory_order_relaxed);
+		OutStats.AllocBlockCount += Stats.AllocBlockCount.load(std::memory_order_relaxed);
+		OutStats.FreeBlockCount += Stats.FreeBlockCount.load(std::memory_order_relaxed);
+		OutStats.LockCount += Stats.LockCount.load(std::memory_order_relaxed);
+		OutStats.LockContendedCount += Stats.LockContendedCount.load(std::memory_order_relaxed);
+		OutStats.LockSpinNanoseconds += Stats.LockSpinNanoseconds.load(std::memory_order_relaxed);
+	}
+
+	OutStats.DeferredFlushCount = DeferredFlushCount;
+	OutStats.DeferredFreeCount = DeferredFreeCount;
+	OutStats.DeferredMaxBatchSize = DeferredMaxBatchSize;
+	OutStats.DeferredFlushLatencyNanoseconds = DeferredFlushLatencyNanoseconds;
+	OutStats.DeferredMaxFlushLatencyNanoseconds = DeferredMaxFlushLatencyNanoseconds;
+
+	OutStats.PageCount = PageCount;
+	OutStats.BlockInUseCount = OutStats.AllocBlockCount - OutStats.FreeBlockCount;
+	OutStats.PageBlockInUseCount = PageBlockInUseCount;
+	OutStats.PeakPageBlockInUseCount = PeakPageBlockInUseCount;
+
+	// rates since previous call
+	uint64 CurrTime = appGetTimeMilliseconds();
+	if (LastStatsTime != 0 && CurrTime > LastStatsTime)
+	{
+		float ElapsedSeconds = (float)(CurrTime - LastStatsTime) / 1000.0f;
+		OutStats.AllocRate = (float)(OutStats.AllocCount - LastStatsAllocCount) / ElapsedSeconds;
+		OutStats.FreeRate = (float)(OutStats.FreeCount - LastStatsFreeCount) / ElapsedSeconds;
+	}
+
+	LastStatsTime = CurrTime;
+	LastStatsAllocCount = OutStats.AllocCount;
+	LastStatsFreeCount = OutStats.FreeCount;
+
+	// free runs of all pages
+	PageWalkScope WalkScope(this);
+	for (int32 Tag = 0; Tag < MemoryTag_Count; ++Tag)
 	{
-		if (InValue) // mark it as allocated
+		for (int32 NumaNode = 0; NumaNode < NumaNodeCount; ++NumaNode)
 		{
-			// trigger assert
-			h1MemCheck((Layout.AllocBitMask & (1ll << CurrOffset)) == 0, "invalid alloc bit please check!");
-		}
-		else // mark it as free (deallocated)
+			for (MemoryPage* CurrPage = SubArenas[Tag].PageHeads[NumaNode].load(std::memory_order_acquire); CurrPage != nullptr; CurrPage = CurrPage->GetNextPage())
+			{
+				int32 FreeRunHistogram[FREE_RUN_HISTOGRAM_SIZE];
+				CurrPage->GetFreeRunHistogram(FreeRunHistogram);
+
+				for (int32 RunLength = 1; RunLength < FREE_RUN_HISTOGRAM_SIZE; ++RunLength)
+				{
+					OutStats.FreeRunHistogram[RunLength] += FreeRunHistogram[RunLength];
+				}
+			}
+		}
+	}
+}
+
+int32 H1MemoryArena::GetPageStats(PageStats* OutPageStats, int32 MaxPageCount) const
+{
+	PageWalkScope WalkScope(this);
+
+	int32 PageIndex = 0;
+	for (int32 Tag = 0; Tag < MemoryTag_Count; ++Tag)
+	{
+		for (int32 NumaNode = 0; NumaNode < NumaNodeCount; ++NumaNode)
+		{
+			for (MemoryPage* CurrPage = SubArenas[Tag].PageHeads[NumaNode].load(std::memory_order_acquire); CurrPage != nullptr && PageIndex < MaxPageCount; CurrPage = CurrPage->GetNextPage())
+			{
+				PageStats& Stats = OutPageStats[PageIndex++];
+				Stats.TagId = CurrPage->Layout.TagId;
+				Stats.Tag = CurrPage->Layout.Tag;
+				Stats.NumaNode = CurrPage->Layout.NumaNode;
+				Stats.UsedBlockCount = (int32)appCountBits64(CurrPage->Layout.AllocBitMask.load(std::memory_order_relaxed) & MemoryPage::ALLOC_BIT_MASK_FULL);
+
+				CurrPage->GetFreeRunHistogram(Stats.FreeRunHistogram);
+
+				// longest free run against all free memory blocks
+				Stats.LongestFreeRun = 0;
+				for (int32 RunLength = 1; RunLength < FREE_RUN_HISTOGRAM_SIZE; ++RunLength)
+				{
+					if (Stats.FreeRunHistogram[RunLength] > 0)
+					{
+						Stats.LongestFreeRun = RunLength;
+					}
+				}
+
+				int32 FreeBlockCount = MemoryPage::MEMORY_BLOCK_COUNT - Stats.UsedBlockCount;
+				Stats.Fragmentation = (FreeBlockCount > 0) ? 1.0f - (float)Stats.LongestFreeRun / (float)FreeBlockCount : 0.0f;
+			}
+		}
+	}
+
+	return PageIndex;
+}
+
+void H1MemoryArena::WarmUp(const WarmUpParams& InParams)
+{
+	h1MemCheck(InParams.NumaNode >= 0 && InParams.NumaNode < NumaNodeCount, "invalid NUMA node, please check!");
+
+	uint64 StartTime = appGetTimeNanoseconds();
+
+	WarmUpReport Report;
+	Report.PrefaultedSize = 0;
+
+	for (int32 Tag = 0; Tag < MemoryTag_Count; ++Tag)
+	{
+		SubArena& CurrSubArena = SubArenas[Tag];
+		Report.PageCounts[Tag] = 0;
+		Report.BlockCounts[Tag] = 0;
+
+		// 1. create pages ahead (page headers are committed, heap backed page is zero-filled as a whole)
+		LockSyncObject(CurrSubArena.SyncObject);
+		while (CurrSubArena.PageCount < InParams.PageCounts[Tag])
+		{
+			AllocatePage(InParams.NumaNode, (MemoryTag)Tag);
+			Report.PageCounts[Tag]++;
+		}
+		CurrSubArena.SyncObject.UnLock();
+
+		// 2. commit and prefault memory blocks
+		//	- hold all prefaulted memory blocks until the end, otherwise same memory block is handed out again
+		//	- they are linked through their first bytes, so it doesn't need any extra memory
+		byte* PrefaultedHead = nullptr;
+		for (int32 BlockIndex = 0; BlockIndex < InParams.BlockCounts[Tag]; ++BlockIndex)
+		{
+			H1MemoryBlock MemoryBlock = AllocateMemoryBlockOnNode(InParams.NumaNode, (MemoryTag)Tag);
+			if (MemoryBlock.BaseAddress == nullptr)
+			{
+				// over the hard budget of the tag
+				break;
+			}
+
+			appPrefaultVirtualMemory(MemoryBlock.BaseAddress, MEMORY_BLOCK_SIZE);
+
+			*(byte**)MemoryBlock.BaseAddress = PrefaultedHead;
+			PrefaultedHead = MemoryBlock.BaseAddress;
+
+			Report.BlockCounts[Tag]++;
+			Report.PrefaultedSize += MEMORY_BLOCK_SIZE;
+		}
+
+		// 3. hand back prefaulted memory blocks to pages directly, they stay committed
+		//	- not through magazine of the warm-up thread, other threads take them from pages
+		while (PrefaultedHead != nullptr)
+		{
+			MemoryPage::DeallocInput Input;
+			Input.BaseAddress = PrefaultedHead;
+			PrefaultedHead = *(byte**)PrefaultedHead;
+
+			DeallocateInternal(Input);
+			RecordFree(Input.Count);
+			ReleaseTagBudget(Input.Tag, (int64)Input.Count * MEMORY_BLOCK_SIZE);
+		}
+	}
+
+	Report.ElapsedNanoseconds = (int64)(appGetTimeNanoseconds() - StartTime);
+
+	// publish the report
+	LastWarmUpReport = Report;
+	bWarmUpDone.store(true, std::memory_order_release);
+}
+
+bool H1MemoryArena::GetWarmUpReport(WarmUpReport& OutReport) const
+{
+	if (!bWarmUpDone.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	OutReport = LastWarmUpReport;
+	return true;
+}
+
+bool H1MemoryArena::OpenPersistentImage(const char* FilePath, int64 MaxPageCount, byte* FixedBaseAddress)
+{
+	h1MemCheck(Backing == PersistentFile, "only for persistent file backed memory arena, please check!");
+	h1MemCheck(PersistentHeader == nullptr, "persistent image is already opened, please check!");
+	h1MemCheck(PageCount == 0, "persistent image should be opened before any allocation, please check!");
+	h1MemCheck(Align(FixedBaseAddress, MEMORY_PAGE_SIZE) == FixedBaseAddress, "base address should be aligned to memory page size, please check!");
+	h1MemCheck(MaxPageCount <= MAX_PAGE_COUNT, "too many memory pages for the page table, please check!");
+
+	// image header and page table should fit in the image header region
+	SGD_CT_ASSERT(sizeof(PersistentImageHeader) <= PERSISTENT_PAGE_TABLE_OFFSET);
+	SGD_CT_ASSERT(PERSISTENT_PAGE_TABLE_OFFSET + MAX_PAGE_COUNT * sizeof(MemoryPage) <= PERSISTENT_IMAGE_HEADER_SIZE);
+
+	PersistentFileHandle = appOpenMappedFile(FilePath, PERSISTENT_IMAGE_HEADER_SIZE + MaxPageCount * MEMORY_PAGE_SIZE);
+	if (PersistentFileHandle == -1)
+	{
+		return false;
+	}
+
+	PersistentHeader = (PersistentImageHeader*)appMapFileView(PersistentFileHandle, 0, PERSISTENT_IMAGE_HEADER_SIZE, nullptr);
+	if (PersistentHeader == nullptr)
+	{
+		ClosePersistentImage();
+		return false;
+	}
+
+	// validate the reopened image
+	bool bReopened = (PersistentHeader->Magic == PERSISTENT_IMAGE_MAGIC);
+	if (bReopened)
+	{
+		if (PersistentHeader->Version != PERSISTENT_IMAGE_VERSION || PersistentHeader->PageSize != MEMORY_PAGE_SIZE)
+		{
+			ClosePersistentImage();
+			return false;
+		}
+
+		// the file is never shrunk
+		if (PersistentHeader->MaxPageCount > MaxPageCount)
+		{
+			MaxPageCount = PersistentHeader->MaxPageCount;
+		}
+	}
+
+	// map pages at the fixed address (or the address of previous mapping)
+	int64 PagesSize = MaxPageCount * MEMORY_PAGE_SIZE;
+	byte* DesiredAddress = (FixedBaseAddress != nullptr) ? FixedBaseAddress : (bReopened ? (byte*)PersistentHeader->BaseAddress : nullptr);
+	if (DesiredAddress != nullptr)
+	{
+		PersistentBaseAddress = appMapFileView(PersistentFileHandle, PERSISTENT_IMAGE_HEADER_SIZE, PagesSize, DesiredAddress);
+	}
+
+	if (PersistentBaseAddress == nullptr)
+	{
+		// the address is taken, relocate it to other aligned address range
+		byte* AlignedAddress = appReserveAlignedVirtualMemory(PagesSize, MEMORY_PAGE_SIZE);
+		if (AlignedAddress != nullptr)
+		{
+			appReleaseVirtualMemory(AlignedAddress, PagesSize);
+			PersistentBaseAddress = appMapFileView(PersistentFileHandle, PERSISTENT_IMAGE_HEADER_SIZE, PagesSize, AlignedAddress);
+		}
+
+		if (PersistentBaseAddress == nullptr)
+		{
+			ClosePersistentImage();
+			return false;
+		}
+	}
+
+	PersistentMaxPageCount = MaxPageCount;
+	PageTable = (MemoryPage*)((byte*)PersistentHeader + PERSISTENT_PAGE_TABLE_OFFSET);
+	bPersistentRelocated = bReopened && (PersistentBaseAddress != (byte*)PersistentHeader->BaseAddress);
+
+	if (bReopened)
+	{
+		RestorePersistentPages();
+	}
+	else
+	{
+		// new image
+		PersistentHeader->Magic = PERSISTENT_IMAGE_MAGIC;
+		PersistentHeader->Version = PERSISTENT_IMAGE_VERSION;
+		PersistentHeader->PageSize = MEMORY_PAGE_SIZE;
+		PersistentHeader->PageCount = 0;
+		PersistentHeader->CheckpointCount = 0;
+		for (int32 RootIndex = 0; RootIndex < MAX_PERSISTENT_ROOT_COUNT; ++RootIndex)
+		{
+			PersistentHeader->Roots[RootIndex] = -1;
+		}
+	}
+
+	PersistentHeader->MaxPageCount = MaxPageCount;
+	PersistentHeader->BaseAddress = (uint64)PersistentBaseAddress;
+
+	return true;
+}
+
+void H1MemoryArena::RestorePersistentPages()
+{
+	for (int64 PageIndex = 0; PageIndex < PersistentHeader->PageCount; ++PageIndex)
+	{
+		// memory blocks address is not valid for relocated image
+		MemoryPage* Page = &PageTable[PageIndex];
+		Page->Layout.MemoryBlocks = (MemoryBlock*)(PersistentBaseAddress + PageIndex * MEMORY_PAGE_SIZE);
+
+		// NUMA topology could be changed since the image is created
+		if (Page->Layout.NumaNode >= NumaNodeCount)
+		{
+			Page->Layout.NumaNode = 0;
+		}
+
+		PageDirectory.Register(Page);
+		Page->UpdateLongestFreeRun();
+
+		// rebuild page lists (next page pointer is not valid for relocated image)
+		SubArena& CurrSubArena = SubArenas[Page->Layout.Tag];
+		Page->SetNextPage(CurrSubArena.PageHeads[Page->Layout.NumaNode].load());
+		CurrSubArena.PageHeads[Page->Layout.NumaNode].store(Page);
+
+		// restore statistics from alloc bit mask
+		int64 UsedBlockCount = appCountBits64(Page->Layout.AllocBitMask.load() & MemoryPage::ALLOC_BIT_MASK_FULL);
+		CurrSubArena.UsedSize += UsedBlockCount * MEMORY_BLOCK_SIZE;
+		CurrSubArena.PageCount++;
+		PageBlockInUseCount += UsedBlockCount;
+		PageCount++;
+
+		ReservedSize += MEMORY_PAGE_SIZE;
+		CommittedSize += MEMORY_PAGE_SIZE;
+	}
+
+	// unique id is same as the page slot in the image
+	NextPageTagId = (uint32)PersistentHeader->PageCount;
+}
+
+bool H1MemoryArena::CheckpointPersistentImage()
+{
+	h1MemCheck(PersistentHeader != nullptr, "persistent image is not opened, please check!");
+
+	// flush pages first, and then the header (the header never refers the page which is not flushed)
+	bool bFlushed = appFlushFileView(PersistentBaseAddress, PersistentHeader->PageCount * MEMORY_PAGE_SIZE);
+
+	// page table is flushed with the header
+	PersistentHeader->CheckpointCount++;
+	bFlushed = appFlushFileView((byte*)PersistentHeader, PERSISTENT_PAGE_TABLE_OFFSET + PersistentHeader->PageCount * sizeof(MemoryPage)) && bFlushed;
+
+	return bFlushed;
+}
+
+void H1MemoryArena::ClosePersistentImage()
+{
+	if (PersistentBaseAddress != nullptr)
+	{
+		appUnmapFileView(PersistentBaseAddress, PersistentMaxPageCount * MEMORY_PAGE_SIZE);
+		PersistentBaseAddress = nullptr;
+	}
+
+	if (PersistentHeader != nullptr)
+	{
+		appUnmapFileView((byte*)PersistentHeader, PERSISTENT_IMAGE_HEADER_SIZE);
+		PersistentHeader = nullptr;
+		PageTable = nullptr;
+	}
+
+	if (PersistentFileHandle != -1)
+	{
+		appCloseMappedFile(PersistentFileHandle);
+		PersistentFileHandle = -1;
+	}
+
+	PersistentMaxPageCount = 0;
+	bPersistentRelocated = false;
+}
+
+int64 H1MemoryArena::GetPersistentOffset(const void* Address) const
+{
+	int64 Offset = (const byte*)Address - PersistentBaseAddress;
+	h1MemCheck(PersistentBaseAddress != nullptr && Offset >= 0 && Offset < PersistentMaxPageCount * MEMORY_PAGE_SIZE, "address is not in persistent image, please check!");
+
+	return Offset;
+}
+
+byte* H1MemoryArena::GetPersistentAddress(int64 Offset) const
+{
+	h1MemCheck(PersistentBaseAddress != nullptr && Offset >= 0 && Offset < PersistentMaxPageCount * MEMORY_PAGE_SIZE, "offset is out of persistent image, please check!");
+
+	return PersistentBaseAddress + Offset;
+}
+
+void H1MemoryArena::SetPersistentRoot(int32 RootIndex, int64 Offset)
+{
+	h1MemCheck(PersistentHeader != nullptr && RootIndex >= 0 && RootIndex < MAX_PERSISTENT_ROOT_COUNT, "invalid persistent root, please check!");
+	PersistentHeader->Roots[RootIndex] = Offset;
+}
+
+int64 H1MemoryArena::GetPersistentRoot(int32 RootIndex) const
+{
+	h1MemCheck(PersistentHeader != nullptr && RootIndex >= 0 && RootIndex < MAX_PERSISTENT_ROOT_COUNT, "invalid persistent root, please check!");
+	return PersistentHeader->Roots[RootIndex];
+}
+
+// thread-local caches must not be touched after they are destroyed at thread exit (e.g. by static destructors on main thread)
+//	- trivially destructible thread_local is never destroyed, so these flags are valid until the thread is terminated
+static thread_local bool GThreadMagazineCacheDestroyed = false;
+static thread_local bool GThreadDeferredFreeQueueDestroyed = false;
+
+H1MemoryArena::BlockMagazineCache::~BlockMagazineCache()
+{
+	GThreadMagazineCacheDestroyed = true;
+
+	if (Owner == nullptr)
+	{
+		return;
+	}
+
+	// unbind from the owner memory arena first, so it doesn't touch this cache anymore
+	{
+		SGD::Thread::H1ScopeLock ScopeLock(&Owner->DepotSyncObject);
+		Owner->UnbindMagazineCache(this);
+	}
+
+	// return cached memory blocks to the owner memory arena
+	BlockMagazine* Magazines[] = { Loaded, Previous };
+	for (BlockMagazine* Magazine : Magazines)
+	{
+		if (Magazine != nullptr)
+		{
+			Owner->FlushMagazine(Magazine);
+			delete Magazine;
+		}
+	}
+}
+
+H1MemoryArena::BlockMagazineCache* H1MemoryArena::GetThreadMagazineCache()
+{
+	static thread_local BlockMagazineCache ThreadMagazineCache;
+	return GThreadMagazineCacheDestroyed ? nullptr : &ThreadMagazineCache;
+}
+
+H1MemoryArena::BlockMagazineCache* H1MemoryArena::GetMagazineCache()
+{
+	// cached memory blocks in magazines would be leaked in persistent image
+	if (Backing == PersistentFile)
+	{
+		return nullptr;
+	}
+
+	// the thread is terminating
+	BlockMagazineCache* Cache = GetThreadMagazineCache();
+	if (Cache == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (Cache->Owner == nullptr)
+	{
+		// bind the thread-local magazines to this memory arena
+		Cache->Loaded = new BlockMagazine();
+		Cache->Previous = new BlockMagazine();
+
+		SGD::Thread::H1ScopeLock ScopeLock(&DepotSyncObject);
+		Cache->Owner = this;
+		Cache->NextBound = BoundCacheHead;
+		BoundCacheHead = Cache;
+	}
+
+	return (Cache->Owner == this) ? Cache : nullptr;
+}
+
+byte* H1MemoryArena::AllocateFromMagazine(BlockMagazineCache* Cache)
+{
+	// 1. loaded magazine has memory block
+	if (!Cache->Loaded->IsEmpty())
+	{
+		return Cache->Loaded->Pop();
+	}
+
+	// 2. previous magazine is full, swap it with loaded
+	if (Cache->Previous->IsFull())
+	{
+		SGD::swap(Cache->Loaded, Cache->Previous);
+		return Cache->Loaded->Pop();
+	}
+
+	// 3. exchange empty magazine with full magazine in depot
+	BlockMagazine* FullMagazine = nullptr;
+	{
+		SGD::Thread::H1ScopeLock ScopeLock(&DepotSyncObject);
+		if (DepotFullHead != nullptr)
+		{
+			FullMagazine = DepotFullHead;
+			DepotFullHead = FullMagazine->Next;
+			DepotFullCount--;
+
+			// previous (empty) magazine goes to depot
+			Cache->Previous->Next = DepotEmptyHead;
+			DepotEmptyHead = Cache->Previous;
+		}
+	}
+
+	if (FullMagazine != nullptr)
+	{
+		DepotHitCount++;
+
+		Cache->Previous = Cache->Loaded;
+		Cache->Loaded = FullMagazine;
+		return Cache->Loaded->Pop();
+	}
+
+	// 4. depot has no full magazine, fill loaded magazine from memory pages in a batch
+	DepotMissCount++;
+
+	FillMagazine(Cache->Loaded);
+	return Cache->Loaded->Pop();
+}
+
+void H1MemoryArena::DeallocateToMagazine(BlockMagazineCache* Cache, byte* InAddress)
+{
+	// 1. loaded magazine has space
+	if (!Cache->Loaded->IsFull())
+	{
+		Cache->Loaded->Push(InAddress);
+		return;
+	}
+
+	// 2. previous magazine is empty, swap it with loaded
+	if (Cache->Previous->IsEmpty())
+	{
+		SGD::swap(Cache->Loaded, Cache->Previous);
+		Cache->Loaded->Push(InAddress);
+		return;
+	}
+
+	// 3. exchange full magazine with empty magazine in depot
+	BlockMagazine* EmptyMagazine = nullptr;
+	BlockMagazine* MagazineToFlush = nullptr;
+	{
+		SGD::Thread::H1ScopeLock ScopeLock(&DepotSyncObject);
+		if (DepotEmptyHead != nullptr)
+		{
+			EmptyMagazine = DepotEmptyHead;
+			DepotEmptyHead = EmptyMagazine->Next;
+		}
+
+		if (DepotFullCount < DEPOT_FULL_MAGAZINE_LIMIT)
+		{
+			// previous (full) magazine goes to depot
+			Cache->Previous->Next = DepotFullHead;
+			DepotFullHead = Cache->Previous;
+			DepotFullCount++;
+		}
+		else
+		{
+			// depot holds enough memory blocks, return them to memory pages
+			MagazineToFlush = Cache->Previous;
+		}
+	}
+
+	if (EmptyMagazine != nullptr)
+	{
+		DepotHitCount++;
+	}
+	else
+	{
+		DepotMissCount++;
+		EmptyMagazine = new BlockMagazine();
+	}
+
+	if (MagazineToFlush != nullptr)
+	{
+		FlushMagazine(MagazineToFlush);
+		delete MagazineToFlush;
+	}
+
+	Cache->Previous = Cache->Loaded;
+	Cache->Loaded = EmptyMagazine;
+	Cache->Loaded->Push(InAddress);
+}
+
+void H1MemoryArena::FillMagazine(BlockMagazine* Magazine)
+{
+	MemoryPage::AllocInput Input;
+	Input.BlockCount = 1;
+	Input.NumaNode = GetPreferredNumaNode();
+	Input.Placement = Placement;
+
+	while (!Magazine->IsFull())
+	{
+		MemoryPage::AllocOutput Output = AllocateInternal(Input);
+		Magazine->Push(Output.BaseAddress);
+	}
+}
+
+void H1MemoryArena::FlushMagazine(BlockMagazine* Magazine)
+{
+	while (!Magazine->IsEmpty())
+	{
+		MemoryPage::DeallocInput Input;
+		Input.BaseAddress = Magazine->Pop();
+		Input.Count = 1;
+
+		DeallocateInternal(Input);
+	}
+}
+
+void H1MemoryArena::DestroyMagazines()
+{
+	// memory blocks in magazines are released with memory pages
+	SGD::Thread::H1ScopeLock ScopeLock(&DepotSyncObject);
+
+	BlockMagazine* Heads[] = { DepotFullHead, DepotEmptyHead };
+	for (BlockMagazine* CurrMagazine : Heads)
+	{
+		while (CurrMagazine != nullptr)
+		{
+			BlockMagazine* MagazineToRemove = CurrMagazine;
+			CurrMagazine = CurrMagazine->Next;
+			delete MagazineToRemove;
+		}
+	}
+
+	DepotFullHead = nullptr;
+	DepotEmptyHead = nullptr;
+	DepotFullCount = 0;
+
+	// unbind all threads' magazine caches, so no cache keeps dangling owner pointer
+	//	- other threads must not allocate from this memory arena while it is destroyed
+	while (BoundCacheHead != nullptr)
+	{
+		BlockMagazineCache* Cache = BoundCacheHead;
+		BoundCacheHead = Cache->NextBound;
+
+		delete Cache->Loaded;
+		delete Cache->Previous;
+
+		Cache->Owner = nullptr;
+		Cache->Loaded = nullptr;
+		Cache->Previous = nullptr;
+		Cache->NextBound = nullptr;
+	}
+}
+
+void H1MemoryArena::UnbindMagazineCache(BlockMagazineCache* Cache)
+{
+	BlockMagazineCache** Link = &BoundCacheHead;
+	while (*Link != nullptr)
+	{
+		if (*Link == Cache)
+		{
+			*Link = Cache->NextBound;
+			Cache->NextBound = nullptr;
+			return;
+		}
+		Link = &(*Link)->NextBound;
+	}
+}
+
+H1MemoryArena::DeferredFreeQueue::~DeferredFreeQueue()
+{
+	GThreadDeferredFreeQueueDestroyed = true;
+
+	if (Owner == nullptr)
+	{
+		return;
+	}
+
+	// unbind from the owner memory arena first, so it doesn't flush this queue anymore
+	{
+		SGD::Thread::H1ScopeLock ScopeLock(&Owner->BoundQueueSyncObject);
+		Owner->UnbindDeferredFreeQueue(this);
+	}
+
+	// hand back deferred memory blocks to the owner memory arena
+	Owner->FlushDeferredFreeQueue(this);
+	Owner = nullptr;
+}
+
+H1MemoryArena::DeferredFreeQueue* H1MemoryArena::GetThreadDeferredFreeQueue()
+{
+	static thread_local DeferredFreeQueue ThreadDeferredFreeQueue;
+	return GThreadDeferredFreeQueueDestroyed ? nullptr : &ThreadDeferredFreeQueue;
+}
+
+H1MemoryArena::DeferredFreeQueue* H1MemoryArena::GetDeferredFreeQueue()
+{
+	// deferred memory blocks would be leaked in persistent image
+	if (Backing == PersistentFile)
+	{
+		return nullptr;
+	}
+
+	// the thread is terminating
+	DeferredFreeQueue* Queue = GetThreadDeferredFreeQueue();
+	if (Queue == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (Queue->Owner == nullptr)
+	{
+		// bind the thread-local deferred free queue to this memory arena
+		SGD::Thread::H1ScopeLock ScopeLock(&BoundQueueSyncObject);
+		Queue->Owner = this;
+		Queue->NextBound = BoundQueueHead;
+		BoundQueueHead = Queue;
+	}
+
+	return (Queue->Owner == this) ? Queue : nullptr;
+}
+
+void H1MemoryArena::DeferDeallocateByAddress(void* Address)
+{
+	DeferredFreeQueue* Queue = GetDeferredFreeQueue();
+	if (Queue == nullptr)
+	{
+		DeallocateByAddress(Address);
+		return;
+	}
+
+	// the queue can be flushed by the frame boundary on other thread
+	SGD::Thread::H1ScopeLock ScopeLock(&Queue->SyncObject);
+
+	// the frame is advanced since the first deferred free in the queue
+	uint64 CurrFrame = DeferredFreeFrame.load(std::memory_order_relaxed);
+	if (Queue->Count > 0 && Queue->FrameNumber != CurrFrame)
+	{
+		FlushDeferredFreeQueue(Queue);
+	}
+
+	if (Queue->Count == 0)
+	{
+		Queue->FrameNumber = CurrFrame;
+		Queue->FirstDeferTime = appGetTimeNanoseconds();
+	}
+
+	Queue->Addresses[Queue->Count++] = (byte*)Address;
+
+	// reaching to the threshold
+	if (Queue->Count >= DeferredFreeThreshold)
+	{
+		FlushDeferredFreeQueue(Queue);
+	}
+}
+
+void H1MemoryArena::FlushDeferredFrees()
+{
+	DeferredFreeQueue* Queue = GetDeferredFreeQueue();
+	if (Queue != nullptr)
+	{
+		SGD::Thread::H1ScopeLock ScopeLock(&Queue->SyncObject);
+		FlushDeferredFreeQueue(Queue);
+	}
+}
+
+void H1MemoryArena::FlushAllDeferredFrees()
+{
+	SGD::Thread::H1ScopeLock ScopeLock(&BoundQueueSyncObject);
+
+	for (DeferredFreeQueue* Queue = BoundQueueHead; Queue != nullptr; Queue = Queue->NextBound)
+	{
+		SGD::Thread::H1ScopeLock QueueScopeLock(&Queue->SyncObject);
+		FlushDeferredFreeQueue(Queue);
+	}
+}
+
+void H1MemoryArena::SetDeferredFreeThreshold(int32 InThreshold)
+{
+	if (InThreshold < 1)
+	{
+		InThreshold = 1;
+	}
+	else if (InThreshold > DEFERRED_FREE_QUEUE_SIZE)
+	{
+		InThreshold = DEFERRED_FREE_QUEUE_SIZE;
+	}
+
+	DeferredFreeThreshold = InThreshold;
+}
+
+void H1MemoryArena::FlushDeferredFreeQueue(DeferredFreeQueue* Queue)
+{
+	int32 BatchSize = Queue->Count;
+	if (BatchSize == 0)
+	{
+		return;
+	}
+
+	// group memory blocks by page, so each page's alloc bit mask is changed only once
+	MemoryPage* Pages[DEFERRED_FREE_QUEUE_SIZE];
+	uint64 FreeBitMasks[DEFERRED_FREE_QUEUE_SIZE];
+	int32 PageCountInBatch = 0;
+
+	int64 FreedSizes[MemoryTag_Count] = { 0 };
+	int64 FreedBlockCount = 0;
+	int64 FreeCountInBatch = 0;
+
+	for (int32 Index = 0; Index < BatchSize; ++Index)
+	{
+		byte* Address = Queue->Addresses[Index];
+
+		MemoryPage* Page = PageDirectory.Find(Address);
+		if (Page == nullptr)
+		{
+			// large block is released one by one
+			DeallocateByAddress(Address);
+			continue;
+		}
+
+		// offset and count are resolved by memory header
+		int32 Offset = Page->GetBlockOffset(Address);
+		int32 Count = Page->Layout.Headers[Offset].BlockCount;
+
+		int32 PageIndex = 0;
+		while (PageIndex < PageCountInBatch && Pages[PageIndex] != Page)
+		{
+			PageIndex++;
+		}
+
+		if (PageIndex == PageCountInBatch)
+		{
+			Pages[PageCountInBatch] = Page;
+			FreeBitMasks[PageCountInBatch] = 0;
+			PageCountInBatch++;
+		}
+
+		FreeBitMasks[PageIndex] |= MemoryPage::GetAllocBits(Offset, Count);
+
+		FreedSizes[Page->Layout.Tag] += (int64)Count * MEMORY_BLOCK_SIZE;
+		FreedBlockCount += Count;
+		FreeCountInBatch++;
+	}
+
+	// lock-free deallocation per page
+	for (int32 PageIndex = 0; PageIndex < PageCountInBatch; ++PageIndex)
+	{
+		Pages[PageIndex]->DeallocateBits(FreeBitMasks[PageIndex]);
+	}
+
+	PageBlockInUseCount -= FreedBlockCount;
+
+	// deallocated memory blocks stay committed until they are purged
+	if (IsVirtualMemoryBacked())
+	{
+		FreeCommittedSize += FreedBlockCount * MEMORY_BLOCK_SIZE;
+	}
+
+	for (int32 Tag = 0; Tag < MemoryTag_Count; ++Tag)
+	{
+		if (FreedSizes[Tag] > 0)
+		{
+			ReleaseTagBudget((MemoryTag)Tag, FreedSizes[Tag]);
+		}
+	}
+
+	RecordFree(FreedBlockCount, FreeCountInBatch);
+
+	// batch statistics
+	int64 Latency = (int64)(appGetTimeNanoseconds() - Queue->FirstDeferTime);
+
+	DeferredFlushCount.fetch_add(1, std::memory_order_relaxed);
+	DeferredFreeCount.fetch_add(BatchSize, std::memory_order_relaxed);
+	DeferredFlushLatencyNanoseconds.fetch_add(Latency, std::memory_order_relaxed);
+
+	int64 MaxBatchSize = DeferredMaxBatchSize.load(std::memory_order_relaxed);
+	while (BatchSize > MaxBatchSize && !DeferredMaxBatchSize.compare_exchange_weak(MaxBatchSize, BatchSize, std::memory_order_relaxed))
+	{
+	}
+
+	int64 MaxLatency = DeferredMaxFlushLatencyNanoseconds.load(std::memory_order_relaxed);
+	while (Latency > MaxLatency && !DeferredMaxFlushLatencyNanoseconds.compare_exchange_weak(MaxLatency, Latency, std::memory_order_relaxed))
+	{
+	}
+
+	Queue->Count = 0;
+}
+
+void H1MemoryArena::UnbindDeferredFreeQueue(DeferredFreeQueue* Queue)
+{
+	DeferredFreeQueue** Link = &BoundQueueHead;
+	while (*Link != nullptr)
+	{
+		if (*Link == Queue)
+		{
+			*Link = Queue->NextBound;
+			Queue->NextBound = nullptr;
+			return;
+		}
+		Link = &(*Link)->NextBound;
+	}
+}
+
+void H1MemoryArena::ReleaseDeferredFreeQueues()
+{
+	// flush and unbind all threads' deferred free queues, so no queue keeps dangling owner pointer
+	//	- other threads must not defer frees to this memory arena while it is destroyed
+	SGD::Thread::H1ScopeLock ScopeLock(&BoundQueueSyncObject);
+
+	while (BoundQueueHead != nullptr)
+	{
+		DeferredFreeQueue* Queue = BoundQueueHead;
+		BoundQueueHead = Queue->NextBound;
+
+		SGD::Thread::H1ScopeLock QueueScopeLock(&Queue->SyncObject);
+		FlushDeferredFreeQueue(Queue);
+
+		Queue->Owner = nullptr;
+		Queue->NextBound = nullptr;
+	}
+}
+
+H1MemoryBlock H1MemoryArena::CreateMemoryBlock(byte* InAddress) const
+{
+	MemoryPage* Page = PageDirectory.Find(InAddress);
+	h1MemCheck(Page != nullptr, "failed to find memory page, please check!");
+
+	H1MemoryBlock NewBlock(Page->Layout.TagId, Page->GetBlockOffset(InAddress));
+	NewBlock.BaseAddress = InAddress;
+	NewBlock.Size = H1MemoryArena::MEMORY_BLOCK_SIZE;
+
+	return NewBlock;
+}
+
+void H1MemoryArena::InitializePageTable()
+{
+	// persistent image has its own page table
+	if (Backing == PersistentFile)
+	{
+		return;
+	}
+
+	// reserve the address range only, page table entries are committed when pages are created
+	PageTable = (MemoryPage*)appReserveAlignedVirtualMemory(MAX_PAGE_COUNT * sizeof(MemoryPage), appGetVirtualMemoryPageSize());
+	h1MemCheck(PageTable != nullptr, "failed to reserve virtual memory for page table");
+}
+
+void H1MemoryArena::DestroyPageTable()
+{
+	if (Backing != PersistentFile && PageTable != nullptr)
+	{
+		appReleaseVirtualMemory((byte*)PageTable, MAX_PAGE_COUNT * sizeof(MemoryPage));
+	}
+
+	PageTable = nullptr;
+	PageTableCommittedSize = 0;
+}
+
+H1MemoryArena::MemoryPage* H1MemoryArena::CommitPageTableEntry(uint32 TagId)
+{
+	h1MemCheck(PageTable != nullptr, "page table is not initialized, please check!");
+	h1MemCheck(TagId < MAX_PAGE_COUNT, "page table is full, please check!");
+
+	MemoryPage* Entry = &PageTable[TagId];
+
+	// commit the page table by OS pages (persistent image's page table is already mapped with the image)
+	//	- newly committed memory is already zero-filled by OS, so we don't need to reset it
+	int64 RequiredSize = (byte*)(Entry + 1) - (byte*)PageTable;
+	if (Backing != PersistentFile && RequiredSize > PageTableCommittedSize)
+	{
+		int64 CommitSize = Align(RequiredSize - PageTableCommittedSize, appGetVirtualMemoryPageSize());
+		bool bCommitted = appCommitVirtualMemory((byte*)PageTable + PageTableCommittedSize, CommitSize);
+		h1MemCheck(bCommitted, "failed to commit page table");
+
+		PageTableCommittedSize += CommitSize;
+		CommittedSize += CommitSize;
+	}
+
+	return Entry;
+}
+
+H1MemoryArena::MemoryPage* H1MemoryArena::AllocatePage(int32 NumaNode, MemoryTag InTag)
+{
+	byte* PageAddress = nullptr;
+
+	// memory blocks of the page (headers and properties are in the page table)
+	if (IsVirtualMemoryBacked())
+	{
+		// reserve the address range only (no physical memory is backed yet)
+		//	- aligned to its own size, memory blocks are also aligned to MEMORY_BLOCK_SIZE (same as huge page size)
+		PageAddress = appReserveAlignedVirtualMemory(MEMORY_PAGE_SIZE, MEMORY_PAGE_SIZE);
+		h1MemCheck(PageAddress != nullptr, "failed to reserve virtual memory for memory page");
+
+		// bind the page to NUMA node before any memory block is touched
+		if (NumaNodeCount > 1)
+		{
+			appBindVirtualMemoryToNumaNode(PageAddress, MEMORY_PAGE_SIZE, NumaNode);
+		}
+
+		ReservedSize += MEMORY_PAGE_SIZE;
+	}
+	else if (Backing == PersistentFile)
+	{
+		h1MemCheck(PersistentHeader != nullptr, "persistent image is not opened, please check!");
+
+		// the page slot in the image is decided by unique id below
+		//	- file is extended as sparse, so the page is already zero-filled
+		ReservedSize += MEMORY_PAGE_SIZE;
+		CommittedSize += MEMORY_PAGE_SIZE;
+	}
+	else
+	{
+		// create new page (aligned to its own size)
+		PageAddress = (byte*)appAlignedMalloc(MEMORY_PAGE_SIZE, MEMORY_PAGE_SIZE);
+		h1MemCheck(PageAddress != nullptr, "failed to allocate memory page");
+
+		// bind the page to NUMA node before it is zero-filled (first touch)
+		if (NumaNodeCount > 1)
+		{
+			appBindVirtualMemoryToNumaNode(PageAddress, MEMORY_PAGE_SIZE, NumaNode);
+		}
+
+		// reset the page
+		SGD::Platform::Util::appMemzero(PageAddress, MEMORY_PAGE_SIZE);
+
+		ReservedSize += MEMORY_PAGE_SIZE;
+		CommittedSize += MEMORY_PAGE_SIZE;
+	}
+
+	// set unique id, take the page table entry and register to page directory for address look up (shared by all sub-arenas)
+	LockSyncObject(MemoryArenaSyncObject);
+
+	MemoryPage* NewPage = nullptr;
+	ReclaimRetiredPages();
+	if (FreePageEntryHead != nullptr)
+	{
+		// reuse the page table entry of retired page (its unique id is reused as well)
+		NewPage = FreePageEntryHead;
+		FreePageEntryHead = NewPage->Layout.NextRetiredPage;
+
+		NewPage->Layout.AllocBitMask = 0;
+		NewPage->Layout.CommitBitMask = 0;
+		NewPage->Layout.HugeExplicitBitMask = 0;
+		NewPage->Layout.HugeTransparentBitMask = 0;
+		NewPage->Layout.NextRetiredPage = nullptr;
+	}
+	else
+	{
+		uint32 TagId = NextPageTagId++;
+
+		if (Backing == PersistentFile)
+		{
+			// take next page slot in the image (the slot is same as unique id)
+			h1MemCheck(TagId < PersistentMaxPageCount, "persistent image is full, please check!");
+			PageAddress = PersistentBaseAddress + (int64)TagId * MEMORY_PAGE_SIZE;
+			PersistentHeader->PageCount = TagId + 1;
+		}
+
+		NewPage = CommitPageTableEntry(TagId);
+		NewPage->Layout.TagId = TagId;
+	}
+
+	NewPage->Layout.MemoryBlocks = (MemoryBlock*)PageAddress;
+	PageDirectory.Register(NewPage);
+	MemoryArenaSyncObject.UnLock();
+
+	NewPage->Layout.NumaNode = NumaNode;
+	NewPage->Layout.Tag = InTag;
+	NewPage->Layout.LongestFreeRun = MemoryPage::MEMORY_BLOCK_COUNT;
+	PageCount++;
+
+	SubArena& CurrSubArena = SubArenas[InTag];
+	CurrSubArena.PageCount++;
+
+	// properly link new page
+	//	- publish the page after it is initialized (other threads loop pages without lock)
+	NewPage->SetNextPage(CurrSubArena.PageHeads[NumaNode].load());
+	CurrSubArena.PageHeads[NumaNode].store(NewPage, std::memory_order_release);
+
+	return NewPage;
+}
+
+void H1MemoryArena::DeallocateAllPages()
+{
+	// looping all pages of all sub-arenas and NUMA nodes
+	for (int32 Tag = 0; Tag < MemoryTag_Count; ++Tag)
+	{
+		for (int32 NumaNode = 0; NumaNode < NumaNodeCount; ++NumaNode)
+		{
+			MemoryPage* CurrPage = SubArenas[Tag].PageHeads[NumaNode].exchange(nullptr);
+			while (CurrPage != nullptr)
+			{
+				MemoryPage* PageToRemove = CurrPage;
+
+				// move next page
+				CurrPage = PageToRemove->GetNextPage();
+
+				PageDirectory.Unregister(PageToRemove);
+
+				// release memory blocks of the page (page table entry is released with the page table)
+				if (IsVirtualMemoryBacked())
+				{
+					appReleaseVirtualMemory((byte*)PageToRemove->Layout.MemoryBlocks, MEMORY_PAGE_SIZE);
+				}
+				else if (Backing == PersistentFile)
+				{
+					// pages stay in the image, they are unmapped with the image
+				}
+				else
+				{
+					appAlignedFree((byte*)PageToRemove->Layout.MemoryBlocks);
+				}
+			}
+		}
+	}
+
+	// page table stays committed until it is destroyed
+	ReservedSize = 0;
+	CommittedSize = PageTableCommittedSize;
+	RegularBlockCount = 0;
+	HugeExplicitBlockCount = 0;
+	HugeTransparentBlockCount = 0;
+	FreeCommittedSize = 0;
+	PageCount = 0;
+	PageBlockInUseCount = 0;
+
+	for (int32 Tag = 0; Tag < MemoryTag_Count; ++Tag)
+	{
+		SubArenas[Tag].PageCount = 0;
+	}
+}
+
+H1MemoryArena::MemoryPageDirectory::MemoryPageDirectory()
+{
+	SGD_CT_ASSERT(MemoryPage::MEMORY_BLOCK_COUNT * MEMORY_BLOCK_SIZE == MEMORY_PAGE_SIZE);
+	SGD_CT_ASSERT((1ull << PAGE_SHIFT) == MEMORY_PAGE_SIZE);
+
+	for (int32 RootIndex = 0; RootIndex < ROOT_COUNT; ++RootIndex)
+	{
+		Roots[RootIndex] = nullptr;
+	}
+}
+
+H1MemoryArena::MemoryPageDirectory::~MemoryPageDirectory()
+{
+	for (int32 RootIndex = 0; RootIndex < ROOT_COUNT; ++RootIndex)
+	{
+		delete Roots[RootIndex].load();
+		Roots[RootIndex] = nullptr;
+	}
+}
+
+void H1MemoryArena::MemoryPageDirectory::Register(MemoryPage* Page)
+{
+	uint64 PageIndex = (uint64)Page->Layout.MemoryBlocks >> PAGE_SHIFT;
+	h1MemCheck((PageIndex >> (LEAF_BITS + ROOT_BITS)) == 0, "memory page address is out of directory range!");
+
+	// create the leaf on demand
+	SGD::atomic<MemoryPageDirectoryLeaf*>& Root = Roots[PageIndex >> LEAF_BITS];
+	if (Root.load() == nullptr)
+	{
+		MemoryPageDirectoryLeaf* NewLeaf = new MemoryPageDirectoryLeaf();
+		for (int32 LeafIndex = 0; LeafIndex < LEAF_COUNT; ++LeafIndex)
+		{
+			NewLeaf->Pages[LeafIndex] = nullptr;
+		}
+
+		// publish the leaf after it is initialized
+		Root.store(NewLeaf, std::memory_order_release);
+	}
+
+	Root.load()->Pages[PageIndex & (LEAF_COUNT - 1)].store(Page, std::memory_order_release);
+}
+
+void H1MemoryArena::MemoryPageDirectory::Unregister(MemoryPage* Page)
+{
+	uint64 PageIndex = (uint64)Page->Layout.MemoryBlocks >> PAGE_SHIFT;
+
+	// leaf is not released until the directory is destroyed
+	MemoryPageDirectoryLeaf* Leaf = Roots[PageIndex >> LEAF_BITS].load();
+	if (Leaf != nullptr)
+	{
+		Leaf->Pages[PageIndex & (LEAF_COUNT - 1)] = nullptr;
+	}
+}
+
+H1MemoryArena::MemoryPage* H1MemoryArena::MemoryPageDirectory::Find(const void* Address) const
+{
+	uint64 PageIndex = (uint64)Address >> PAGE_SHIFT;
+	if ((PageIndex >> (LEAF_BITS + ROOT_BITS)) != 0)
+	{
+		return nullptr;
+	}
+
+	MemoryPageDirectoryLeaf* Leaf = Roots[PageIndex >> LEAF_BITS].load(std::memory_order_acquire);
+	if (Leaf == nullptr)
+	{
+		return nullptr;
+	}
+
+	return Leaf->Pages[PageIndex & (LEAF_COUNT - 1)].load(std::memory_order_acquire);
+}
+
+void H1MemoryArena::CommitMemoryBlocks(MemoryPage* Page, int32 Offset, int32 Count)
+{
+	for (int32 CurrOffset = Offset; CurrOffset < Offset + Count; ++CurrOffset)
+	{
+		// already committed memory block is reused as it is
+		uint64 BitMask = (1ull << CurrOffset);
+		if ((Page->Layout.CommitBitMask.load(std::memory_order_acquire) & BitMask) != 0)
+		{
+			FreeCommittedSize -= MEMORY_BLOCK_SIZE;
+			continue;
+		}
+
+		byte* BlockAddress = (byte*)&Page->Layout.MemoryBlocks[CurrOffset];
+
+		// 1. try explicit huge page first
+		if (Backing == HugePage && appCommitVirtualMemoryHugePage(BlockAddress, MEMORY_BLOCK_SIZE))
+		{
+			Page->Layout.HugeExplicitBitMask.fetch_or(BitMask);
+			HugeExplicitBlockCount++;
+		}
+		else
+		{
+			// 2. fallback to regular commit
+			bool bCommitted = appCommitVirtualMemory(BlockAddress, MEMORY_BLOCK_SIZE);
+			h1MemCheck(bCommitted, "failed to commit memory block, please check!");
+
+			// 3. advise transparent huge page (it is only a hint for OS)
+			if (Backing == HugePage && appAdviseHugePage(BlockAddress, MEMORY_BLOCK_SIZE))
+			{
+				Page->Layout.HugeTransparentBitMask.fetch_or(BitMask);
+				HugeTransparentBlockCount++;
+			}
+			else
+			{
+				RegularBlockCount++;
+			}
+		}
+
+		Page->Layout.CommitBitMask.fetch_or(BitMask, std::memory_order_release);
+		CommittedSize += MEMORY_BLOCK_SIZE;
+	}
+}
+
+void H1MemoryArena::DecommitMemoryBlock(MemoryPage* Page, int32 Offset)
+{
+	uint64 BitMask = (1ull << Offset);
+	byte* BlockAddress = (byte*)&Page->Layout.MemoryBlocks[Offset];
+
+	bool bDecommitted = appDecommitVirtualMemory(BlockAddress, MEMORY_BLOCK_SIZE);
+	h1MemCheck(bDecommitted, "failed to decommit memory block, please check!");
+
+	// update block page type counts
+	if ((Page->Layout.HugeExplicitBitMask.fetch_and(~BitMask) & BitMask) != 0)
+	{
+		HugeExplicitBlockCount--;
+	}
+	else if ((Page->Layout.HugeTransparentBitMask.fetch_and(~BitMask) & BitMask) != 0)
+	{
+		HugeTransparentBlockCount--;
+	}
+	else
+	{
+		RegularBlockCount--;
+	}
+
+	Page->Layout.CommitBitMask.fetch_and(~BitMask, std::memory_order_release);
+	CommittedSize -= MEMORY_BLOCK_SIZE;
+	FreeCommittedSize -= MEMORY_BLOCK_SIZE;
+}
+
+int64 H1MemoryArena::PurgeMemoryBlocks(bool bForce)
+{
+	// heap backed memory page can't be decommitted partially
+	if (!IsVirtualMemoryBacked())
+	{
+		return 0;
+	}
+
+	// hysteresis: nothing to do until free committed size reaches to PurgeStartSize
+	if (!bForce && FreeCommittedSize <= PurgeConfig.PurgeStartSize)
+	{
+		return 0;
+	}
+
+	// other thread is purging
+	bool bExpected = false;
+	if (!bPurging.compare_exchange_strong(bExpected, true))
+	{
+		return 0;
+	}
+
+	uint64 CurrTime = appGetTimeMilliseconds();
+	int64 RetainSize = bForce ? 0 : PurgeConfig.RetainSize;
+	int64 PurgedSizeInThisPurge = 0;
+
+	// pages retired by this purge should not be reused while looping
+	{
+		PageWalkScope WalkScope(this);
+
+		for (int32 Tag = 0; Tag < MemoryTag_Count; ++Tag)
+		{
+			for (int32 NumaNode = 0; NumaNode < NumaNodeCount; ++NumaNode)
+			{
+				MemoryPage* CurrPage = SubArenas[Tag].PageHeads[NumaNode].load(std::memory_order_acquire);
+				while (CurrPage != nullptr)
+				{
+					// candidates: committed but free memory blocks
+					uint64 AllocBitMask = CurrPage->Layout.AllocBitMask.load(std::memory_order_acquire);
+					uint64 CandidateMask = (FreeCommittedSize > RetainSize) ? ~AllocBitMask & CurrPage->Layout.CommitBitMask.load(std::memory_order_acquire) & MemoryPage::ALLOC_BIT_MASK_FULL : 0;
+
+					uint64 Offset = 0;
+					while (appBitScanForward64(Offset, CandidateMask) && FreeCommittedSize > RetainSize)
+					{
+						appBitTestAndReset64(Offset, CandidateMask);
+
+						// not yet decayed
+						if (!bForce && CurrTime - CurrPage->Layout.FreeTimes[Offset] < PurgeConfig.DecayMilliseconds)
+						{
+							continue;
+						}
+
+						// claim the memory block like allocation, so no one can allocate it while decommitting
+						uint64 BitMask = (1ull << Offset);
+						if (!CurrPage->ClaimFreeBlock((int32)Offset))
+						{
+							continue;
+						}
+
+						DecommitMemoryBlock(CurrPage, (int32)Offset);
+
+						// release the claimed memory block
+						CurrPage->Layout.AllocBitMask.fetch_and(~BitMask, std::memory_order_release);
+						CurrPage->UpdateLongestFreeRun();
+
+						PurgedBlockCount++;
+						PurgedSizeInThisPurge += MEMORY_BLOCK_SIZE;
+					}
+
+					// move to next page (retired page keeps its next page)
+					MemoryPage* PageToRetire = CurrPage;
+					CurrPage = CurrPage->GetNextPage();
+
+					// unmap the page which has nothing committed (its memory blocks are all decayed and decommitted, or never used)
+					if (PageToRetire->Layout.AllocBitMask.load(std::memory_order_relaxed) == 0 && PageToRetire->Layout.CommitBitMask.load(std::memory_order_relaxed) == 0)
+					{
+						RetirePage(PageToRetire);
+					}
+				}
+			}
+		}
+	}
+
+	// retired page table entries could be reusable already
+	{
+		SGD::Thread::H1ScopeLock ScopeLock(&MemoryArenaSyncObject);
+		ReclaimRetiredPages();
+	}
+
+	PurgeCount++;
+	PurgedSize += PurgedSizeInThisPurge;
+	LastPurgeTime = CurrTime;
+
+	bPurging.store(false);
+
+	return PurgedSizeInThisPurge;
+}
+
+bool H1MemoryArena::RetirePage(MemoryPage* Page)
+{
+	SubArena& CurrSubArena = SubArenas[Page->Layout.Tag];
+	SGD::atomic<MemoryPage*>& PageHead = CurrSubArena.PageHeads[Page->Layout.NumaNode];
+
+	// page list is only changed under the lock of sub-arena (new page is pushed to the head)
+	LockSyncObject(CurrSubArena.SyncObject);
+
+	// keep the last page of the list, so steady allocations don't map and unmap the page repeatedly
+	MemoryPage* PrevPage = nullptr;
+	MemoryPage* CurrPage = PageHead.load();
+	while (CurrPage != nullptr && CurrPage != Page)
+	{
+		PrevPage = CurrPage;
+		CurrPage = CurrPage->GetNextPage();
+	}
+
+	if (CurrPage == nullptr || (PrevPage == nullptr && Page->GetNextPage() == nullptr))
+	{
+		CurrSubArena.SyncObject.UnLock();
+		return false;
+	}
+
+	// claim all memory blocks like allocation, so no one can allocate from the page anymore (the claim is never released)
+	uint64 ExpectedBitMask = 0;
+	if (!Page->Layout.AllocBitMask.compare_exchange_strong(ExpectedBitMask, MemoryPage::ALLOC_BIT_MASK_FULL))
+	{
+		CurrSubArena.SyncObject.UnLock();
+		return false;
+	}
+
+	// the memory block could be allocated, committed and freed again before the claim
+	if (Page->Layout.CommitBitMask.load() != 0)
+	{
+		Page->Layout.AllocBitMask.store(0);
+		CurrSubArena.SyncObject.UnLock();
+		return false;
+	}
+
+	Page->UpdateLongestFreeRun();
+
+	// unlink the page (threads looping the page keep going through its next page)
+	if (PrevPage == nullptr)
+	{
+		PageHead.store(Page->GetNextPage());
+	}
+	else
+	{
+		PrevPage->SetNextPage(Page->GetNextPage());
+	}
+
+	CurrSubArena.PageCount--;
+	CurrSubArena.SyncObject.UnLock();
+
+	// unregister and unmap the page, page table entry waits until no thread is looping pages
+	LockSyncObject(MemoryArenaSyncObject);
+	PageDirectory.Unregister(Page);
+	appReleaseVirtualMemory((byte*)Page->Layout.MemoryBlocks, MEMORY_PAGE_SIZE);
+
+	Page->Layout.NextRetiredPage = RetiredPageHead;
+	RetiredPageHead = Page;
+	MemoryArenaSyncObject.UnLock();
+
+	ReservedSize -= MEMORY_PAGE_SIZE;
+	PageCount--;
+	RetiredPageCount++;
+
+	return true;
+}
+
+void H1MemoryArena::ReclaimRetiredPages()
+{
+	// the threads which start looping after the page is unlinked never see it, so no page walker means nobody refers retired pages
+	if (RetiredPageHead == nullptr || PageWalkerCount.load() != 0)
+	{
+		return;
+	}
+
+	while (RetiredPageHead != nullptr)
+	{
+		MemoryPage* Page = RetiredPageHead;
+		RetiredPageHead = Page->Layout.NextRetiredPage;
+
+		Page->Layout.NextRetiredPage = FreePageEntryHead;
+		FreePageEntryHead = Page;
+	}
+}
+
+H1MemoryArena::MemoryPage::AllocOutput H1MemoryArena::MemoryPage::Allocate(const AllocInput& Params)
+{
+	AllocOutput Output;
+	Output.TagId = Layout.TagId;
+	Output.Offset = -1;
+	Output.Count = 0;
+
+	// lock-free allocation
+	//	- find available bits from the snapshot, and try to mark them with CAS (retry when other thread changes the mask)
+	uint64 AllocBitMask = Layout.AllocBitMask.load(std::memory_order_relaxed);
+	while (true)
+	{
+		// get the available block index
+		int32 Offset = GetAvailableBlockIndex(AllocBitMask, Params.BlockCount, Params.Placement);
+		if (Offset == -1)
+		{
+			break;
+		}
+
+		// mark alloc bit (AllocBitMask is updated by the current value on failure)
+		uint64 NewAllocBitMask = AllocBitMask | GetAllocBits(Offset, Params.BlockCount);
+		if (Layout.AllocBitMask.compare_exchange_weak(AllocBitMask, NewAllocBitMask, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			// record the block count to deallocate it only by address
+			Layout.Headers[Offset].Offset = (byte)Offset;
+			Layout.Headers[Offset].BlockCount = (byte)Params.BlockCount;
+			UpdateLongestFreeRun();
+
+			// update output results
+			Output.Offset = Offset;
+			Output.Count = Params.BlockCount;
+			break;
+		}
+	}
+
+	// set base address
+	Output.BaseAddress = (byte*)&Layout.MemoryBlocks[Output.Offset];
+
+	return Output;
+}
+
+H1MemoryArena::BlockPageType H1MemoryArena::MemoryPage::GetBlockPageType(int32 Offset) const
+{
+	uint64 BitMask = (1ull << Offset);
+	if ((Layout.CommitBitMask & BitMask) == 0)
+	{
+		return BlockPage_NotCommitted;
+	}
+
+	if ((Layout.HugeExplicitBitMask & BitMask) != 0)
+	{
+		return BlockPage_HugeExplicit;
+	}
+
+	if ((Layout.HugeTransparentBitMask & BitMask) != 0)
+	{
+		return BlockPage_HugeTransparent;
+	}
+
+	return BlockPage_Regular;
+}
+
+void H1MemoryArena::MemoryPage::Deallocate(const DeallocInput& Params)
+{
+#if !FINAL_RELEASE
+	// validation check
+	ValidateAllocBits(true, Params.Offset, Params.Count);
+#endif
+
+	// record the free time for purge decay
+	uint64 CurrTime = appGetTimeMilliseconds();
+	for (int32 CurrOffset = Params.Offset; CurrOffset < Params.Offset + Params.Count; ++CurrOffset)
+	{
+		Layout.FreeTimes[CurrOffset] = CurrTime;
+	}
+
+	// just mark as free
+	Layout.AllocBitMask.fetch_and(~GetAllocBits(Params.Offset, Params.Count), std::memory_order_release);
+	UpdateLongestFreeRun();
+}
+
+void H1MemoryArena::MemoryPage::DeallocateBits(uint64 InAllocBits)
+{
+#if !FINAL_RELEASE
+	// validation check
+	h1MemCheck((Layout.AllocBitMask.load(std::memory_order_relaxed) & InAllocBits) == InAllocBits, "invalid alloc bit please check!");
+#endif
+
+	// record the free time for purge decay
+	uint64 CurrTime = appGetTimeMilliseconds();
+	uint64 FreeBits = InAllocBits;
+	uint64 Offset = 0;
+	while (appBitScanForward64(Offset, FreeBits))
+	{
+		appBitTestAndReset64(Offset, FreeBits);
+		Layout.FreeTimes[Offset] = CurrTime;
+	}
+
+	// just mark as free
+	Layout.AllocBitMask.fetch_and(~InAllocBits, std::memory_order_release);
+	UpdateLongestFreeRun();
+}
+
+int32 H1MemoryArena::MemoryPage::GetAvailableBlockIndex(uint64 InAllocBitMask, int32 InBlockCount, BlockPlacement InPlacement)
+{
+	// free bit mask (to use BitScanForward)
+	uint64 FreeBitMask = ~(InAllocBitMask) & ALLOC_BIT_MASK_FULL;
+
+	// first-fit: the lowest start offset of the runs which can contain the memory blocks
+	if (InPlacement == BlockPlacement_FirstFit)
+	{
+		uint64 FirstOffset = 0;
+		if (appBitScanForward64(FirstOffset, GetFreeRunStartMask(FreeBitMask, InBlockCount)))
+		{
+			return (int32)FirstOffset;
+		}
+
+		return -1;
+	}
+
+	// single memory block: isolated free block first, otherwise the first zero bit
+	if (InBlockCount == 1)
+	{
+		uint64 IsolatedBitMask = FreeBitMask & ~(FreeBitMask << 1) & ~(FreeBitMask >> 1);
+		uint64 FirstOffset = 0;
+		if (appBitScanForward64(FirstOffset, IsolatedBitMask) || appBitScanForward64(FirstOffset, FreeBitMask))
+		{
+			return (int32)FirstOffset;
+		}
+
+		return -1;
+	}
+
+	// start offsets of all runs which can contain the memory blocks
+	uint64 RunStartMask = GetFreeRunStartMask(FreeBitMask, InBlockCount);
+
+	// best-fit: loop only fitting free runs and pick the smallest
+	int32 BestOffset = -1;
+	int32 BestRunLength = MEMORY_BLOCK_COUNT + 1;
+
+	uint64 RunOffset = 0;
+	while (appBitScanForward64(RunOffset, RunStartMask))
+	{
+		// the lowest start offset is the beginning of the free run, its length is the count of trailing free bits
+		uint64 RunLengthBits = 0;
+		int32 RunLength = appBitScanForward64(RunLengthBits, ~(FreeBitMask >> RunOffset)) ? (int32)RunLengthBits : (int32)(64 - RunOffset);
+
+		if (RunLength < BestRunLength)
+		{
+			BestOffset = (int32)RunOffset;
+			BestRunLength = RunLength;
+
+			// exact fit
+			if (RunLength == InBlockCount)
+			{
+				break;
+			}
+		}
+
+		// skip the rest of this free run
+		RunStartMask &= ~GetAllocBits((int32)RunOffset, RunLength);
+	}
+
+	return BestOffset;
+}
+
+uint64 H1MemoryArena::MemoryPage::GetFreeRunStartMask(uint64 FreeBitMask, int32 RunLength)
+{
+	// double the folded run length: after folding by N, bit is set when N contiguous bits are set from it
+	uint64 RunStartMask = FreeBitMask;
+	int32 FoldedLength = 1;
+	while (FoldedLength * 2 <= RunLength)
+	{
+		RunStartMask &= RunStartMask >> FoldedLength;
+		FoldedLength *= 2;
+	}
+
+	// fold the remainder (overlapped)
+	if (FoldedLength < RunLength)
+	{
+		RunStartMask &= RunStartMask >> (RunLength - FoldedLength);
+	}
+
+	return RunStartMask;
+}
+
+int32 H1MemoryArena::MemoryPage::CalculateLongestFreeRun(uint64 FreeBitMask)
+{
+	// each folding removes the last bit of every free run
+	int32 LongestFreeRun = 0;
+	while (FreeBitMask != 0)
+	{
+		FreeBitMask &= FreeBitMask >> 1;
+		LongestFreeRun++;
+	}
+
+	return LongestFreeRun;
+}
+
+void H1MemoryArena::MemoryPage::UpdateLongestFreeRun()
+{
+	// recalculate until alloc bit mask is not changed, so the last writer always leaves the summary of current mask
+	uint64 AllocBitMask = Layout.AllocBitMask.load();
+	while (true)
+	{
+		Layout.LongestFreeRun.store(CalculateLongestFreeRun(~AllocBitMask & ALLOC_BIT_MASK_FULL));
+
+		uint64 CurrAllocBitMask = Layout.AllocBitMask.load();
+		if (CurrAllocBitMask == AllocBitMask)
+		{
+			break;
+		}
+
+		AllocBitMask = CurrAllocBitMask;
+	}
+}
+
+void H1MemoryArena::MemoryPage::GetFreeRunHistogram(int32* OutFreeRunHistogram) const
+{
+	for (int32 RunLength = 0; RunLength < FREE_RUN_HISTOGRAM_SIZE; ++RunLength)
+	{
+		OutFreeRunHistogram[RunLength] = 0;
+	}
+
+	// walk the snapshot of alloc bit mask
+	uint64 AllocBitMask = Layout.AllocBitMask.load(std::memory_order_relaxed);
+	int32 RunLength = 0;
+	for (int32 Offset = 0; Offset < MEMORY_BLOCK_COUNT; ++Offset)
+	{
+		if ((AllocBitMask & (1ull << Offset)) == 0)
+		{
+			RunLength++;
+		}
+		else if (RunLength > 0)
+		{
+			OutFreeRunHistogram[RunLength]++;
+			RunLength = 0;
+		}
+	}
+
+	if (RunLength > 0)
+	{
+		OutFreeRunHistogram[RunLength]++;
+	}
+}
+
+bool H1MemoryArena::MemoryPage::ClaimFreeBlock(int32 InOffset)
+{
+	uint64 BitMask = GetAllocBits(InOffset);
+	uint64 AllocBitMask = Layout.AllocBitMask.load(std::memory_order_relaxed);
+	while ((AllocBitMask & BitMask) == 0)
+	{
+		if (Layout.AllocBitMask.compare_exchange_weak(AllocBitMask, AllocBitMask | BitMask, std::memory_order_acquire, std::memory_order_relaxed))
 		{
-			// trigger assert
-			h1MemCheck((Layout.AllocBitMask ^ (1ll << CurrOffset)) == 1, "invalid alloc bit please check!");
+			return true;
 		}
 	}
+
+	// other thread allocated it
+	return false;
+}
+
+uint64 H1MemoryArena::MemoryPage::GetAllocBits(int32 InOffset, int32 InCount)
+{
+	// InCount is 1 ~ 64 (MEMORY_BLOCK_COUNT), (1 << 64) is undefined, so shift down the full mask instead
+	return (ALLOC_BIT_MASK_FULL >> (MEMORY_BLOCK_COUNT - InCount)) << InOffset;
+}
+
+void H1MemoryArena::MemoryPage::ValidateAllocBits(bool InValue, int32 InOffset, int32 InCount)
+{
+	uint64 AllocBitMask = Layout.AllocBitMask.load(std::memory_order_relaxed);
+	uint64 AllocBits = GetAllocBits(InOffset, InCount);
+
+	if (InValue) // all bits should be allocated
+	{
+		// trigger assert
+		h1MemCheck((AllocBitMask & AllocBits) == AllocBits, "invalid alloc bit please check!");
+	}
+	else // all bits should be free (deallocated)
+	{
+		// trigger assert
+		h1MemCheck((AllocBitMask & AllocBits) == 0, "invalid alloc bit please check!");
+	}
 }
@@ -64,11 +64,29 @@ namespace Memory
 		int32 Count;
 	};
 
-	// if it requires more than 126 MB memory size, externally allocate this large block
+	// if it requires more than 128 MB memory size, externally allocate this large block
 	//	- it is not called that frequently!
+	//	- the large block is directly mapped from OS, and tracked in the large block table of MemoryArena
 	class H1MemoryLargeBlock
 	{
 	public:
+		friend class H1MemoryArena;
+
+		H1MemoryLargeBlock(int32 InLargeBlockIndex)
+			: BaseAddress(nullptr)
+			, Size(-1)
+			, LargeBlockIndex(InLargeBlockIndex)
+		{}
+
+		// base address
+		byte* BaseAddress;
+
+		// requested size (mapped size is aligned to MemoryArena::MEMORY_BLOCK_SIZE)
+		int64 Size;
+
+	protected:
+		// index to lookup the large block in MemoryArena (O(1) free)
+		int32 LargeBlockIndex;
 	};
 
 	/*
@@ -78,25 +96,424 @@ namespace Memory
 	class H1MemoryArena
 	{
 	public:
-		H1MemoryArena() {}
-		~H1MemoryArena() {}
+		// memory page backing type
+		//	- every memory page is aligned to its own size (MEMORY_PAGE_SIZE) regardless of backing type
+		//	- Heap: each page is allocated from heap and zero-filled as a whole (128MB of page faults at once)
+		//	- VirtualMemory: each page only reserves its address range, memory blocks are committed when they are handed out
+		//	- HugePage: same as VirtualMemory, but memory blocks are backed by huge page (MAP_HUGETLB -> MADV_HUGEPAGE -> regular)
+		//	- PersistentFile: pages are mapped from the persistent image file (see OpenPersistentImage), magazines and purge are disabled
+		enum BackingType
+		{
+			Heap = 0,
+			VirtualMemory,
+			HugePage,
+			PersistentFile,
+		};
 
-		H1MemoryBlock AllocateMemoryBlock();
-		H1MemoryBlockRange AllocateMemoryBlocks(int32 MemoryBlockCount);
+		// how the committed memory block is backed by OS pages
+		enum BlockPageType
+		{
+			BlockPage_NotCommitted = 0,
+			BlockPage_Regular,
+			BlockPage_HugeExplicit,		// MAP_HUGETLB
+			BlockPage_HugeTransparent,	// MADV_HUGEPAGE (regular page as fallback if OS doesn't promote it)
+		};
+
+		// memory tag (sub-arena)
+		//	- each subsystem allocates from its own pages, so one subsystem never fragments other's pages
+		//	- each tag has its own page lists, page creation lock and byte budget
+		//	- only MemoryTag_Default goes through thread-local magazines
+		enum MemoryTag
+		{
+			MemoryTag_Default = 0,
+			MemoryTag_JobScratch,
+			MemoryTag_Logging,
+			MemoryTag_Assets,
+			MemoryTag_Containers,
+			MemoryTag_Count,
+		};
+
+		// over budget callback
+		//	- called when the allocation goes over the budget of its tag, so caches can evict their memory
+		//	- return true if the memory is released, then the allocation is retried
+		typedef bool (*OverBudgetCallback)(H1MemoryArena* Arena, MemoryTag Tag, int64 RequestedSize, void* UserData);
+
+		H1MemoryArena(BackingType InBackingType = Heap)
+			: NumaNodeCount(1)
+			, bNumaRemoteFallback(false)
+			, NumaRemoteAllocCount(0)
+			, Placement(BlockPlacement_BestFit)
+			, PageTable(nullptr)
+			, PageTableCommittedSize(0)
+			, Backing(InBackingType)
+			, NextPageTagId(0)
+			, ReservedSize(0)
+			, CommittedSize(0)
+			, RegularBlockCount(0)
+			, HugeExplicitBlockCount(0)
+			, HugeTransparentBlockCount(0)
+			, DepotFullHead(nullptr)
+			, DepotEmptyHead(nullptr)
+			, DepotFullCount(0)
+			, BoundCacheHead(nullptr)
+			, DepotHitCount(0)
+			, DepotMissCount(0)
+			, FreeCommittedSize(0)
+			, bPurging(false)
+			, PurgeCount(0)
+			, PurgedBlockCount(0)
+			, PurgedSize(0)
+			, LastPurgeTime(0)
+			, PageWalkerCount(0)
+			, RetiredPageHead(nullptr)
+			, FreePageEntryHead(nullptr)
+			, RetiredPageCount(0)
+			, LargeBlockFreeHead(-1)
+			, LargeBlockUsedCount(0)
+			, LargeBlockCount(0)
+			, LargeBlockSize(0)
+			, LargeAllocCount(0)
+			, LargeRemapCount(0)
+			, LargeCopyCount(0)
+			, BoundQueueHead(nullptr)
+			, DeferredFreeFrame(0)
+			, DeferredFreeThreshold(DEFAULT_DEFERRED_FREE_THRESHOLD)
+			, DeferredFlushCount(0)
+			, DeferredFreeCount(0)
+			, DeferredMaxBatchSize(0)
+			, DeferredFlushLatencyNanoseconds(0)
+			, DeferredMaxFlushLatencyNanoseconds(0)
+			, PageCount(0)
+			, PageBlockInUseCount(0)
+			, PeakPageBlockInUseCount(0)
+			, LastStatsTime(0)
+			, LastStatsAllocCount(0)
+			, LastStatsFreeCount(0)
+			, PersistentFileHandle(-1)
+			, PersistentHeader(nullptr)
+			, PersistentBaseAddress(nullptr)
+			, PersistentMaxPageCount(0)
+			, bPersistentRelocated(false)
+			, bWarmUpDone(false)
+		{
+			InitializeNumaNodes();
+			InitializePageTable();
+		}
+
+		~H1MemoryArena() 
+		{
+			ReleaseDeferredFreeQueues();
+			DestroyMagazines();
+			DeallocateAllPages();
+			DeallocateAllLargeBlocks();
+			ClosePersistentImage();
+			DestroyPageTable();
+		}
+
+		// allocation fails (BaseAddress is nullptr) only when the tag is over its hard budget
+		H1MemoryBlock AllocateMemoryBlock(MemoryTag InTag = MemoryTag_Default);
+		H1MemoryBlockRange AllocateMemoryBlocks(int32 MemoryBlockCount, MemoryTag InTag = MemoryTag_Default);
 
 		void DeallocateMemoryBlock(const H1MemoryBlock& InMemoryBlock);
 		void DeallocateMemoryBlocks(const H1MemoryBlockRange& InMemoryBlocks);
+		// deallocate by base address of memory block (or range) without H1MemoryBlock handle
+		void DeallocateByAddress(void* Address);
+
+		// deferred free
+		//	- releases are collected in thread-local queue, and handed back to memory pages in one batch (one atomic operation per page)
+		//	- the queue is flushed when it reaches the threshold, or on the next deferred free of the thread after the frame is advanced
+		//	- memory blocks are not reusable until they are flushed, so the frame boundary should call FlushAllDeferredFrees
+		//	- deferred memory blocks bypass magazines, and they are freed immediately for persistent image
+		void DeferDeallocateMemoryBlock(const H1MemoryBlock& InMemoryBlock) { DeferDeallocateByAddress(InMemoryBlock.BaseAddress); }
+		void DeferDeallocateMemoryBlocks(const H1MemoryBlockRange& InMemoryBlocks) { DeferDeallocateByAddress(InMemoryBlocks.BaseAddress); }
+		void DeferDeallocateByAddress(void* Address);
+		// flush the deferred free queue of current thread
+		void FlushDeferredFrees();
+		// flush the deferred free queues of all threads bound to this memory arena (frame boundary)
+		void FlushAllDeferredFrees();
+
+		enum
+		{
+			DEFERRED_FREE_QUEUE_SIZE = 256,
+			DEFAULT_DEFERRED_FREE_THRESHOLD = 64,
+		};
+
+		// frame boundary (H1LaunchEngineLoopGlobal::FrameNumber)
+		void SetDeferredFreeFrame(uint64 FrameNumber) { DeferredFreeFrame.store(FrameNumber, std::memory_order_relaxed); }
+		// flush threshold (1 ~ DEFERRED_FREE_QUEUE_SIZE)
+		void SetDeferredFreeThreshold(int32 InThreshold);
+
+		// large block allocation (bigger than the memory page can serve)
+		//	- directly mapped from OS, it doesn't go through memory pages
+		//	- AllocateMemoryBlocks over MEMORY_BLOCK_COUNT (64) blocks is also redirected to large block
+		H1MemoryLargeBlock AllocateLargeBlock(int64 Size, MemoryTag InTag = MemoryTag_Default);
+		// resize the large block, its content is preserved (BaseAddress could be changed)
+		//	- mremap moves physical pages without copying; it copies only when remapping is not supported (windows)
+		//	- returns false (the large block is not changed) when growing is over the hard budget of its tag
+		bool ReallocateLargeBlock(H1MemoryLargeBlock& InOutLargeBlock, int64 NewSize);
+		void DeallocateLargeBlock(const H1MemoryLargeBlock& InLargeBlock);
 	
 		enum { 
 			MEMORY_BLOCK_SIZE = 2 * 1024 * 1024, // memory block size is 2 MB
+			MEMORY_PAGE_SIZE = MEMORY_BLOCK_SIZE * 64, // memory page size is 128 MB (all memory blocks are usable, headers are in the page table)
+			MAX_NUMA_NODE_COUNT = 8,
+			MAX_LARGE_BLOCK_COUNT = 1024,
+			// page tag id for H1MemoryBlockRange redirected to large block (its offset is large block index)
+			LARGE_BLOCK_PAGE_TAG_ID = -2,
+		};
+
+		// NUMA-aware allocation
+		//	- AllocateMemoryBlock(s) prefers the NUMA node of calling thread, below methods target the node explicitly
+		//	- memory pages are listed per NUMA node, and each page is bound to its node (mbind) before it is touched
+		//	- single node machine (or no topology) has only node 0
+		H1MemoryBlock AllocateMemoryBlockOnNode(int32 NumaNode, MemoryTag InTag = MemoryTag_Default);
+		H1MemoryBlockRange AllocateMemoryBlocksOnNode(int32 MemoryBlockCount, int32 NumaNode, MemoryTag InTag = MemoryTag_Default);
+
+		int32 GetNumaNodeCount() const { return NumaNodeCount; }
+		// NUMA node of the memory page containing the address (-1 if it is not arena memory)
+		int32 GetMemoryBlockNumaNode(const void* Address) const;
+
+		// when the node has no free block, allow to take free blocks from other nodes before creating new page
+		void SetNumaRemoteFallback(bool bInNumaRemoteFallback) { bNumaRemoteFallback = bInNumaRemoteFallback; }
+		int64 GetNumaRemoteAllocCount() const { return NumaRemoteAllocCount; }
+
+		// placement of memory blocks in the page
+		//	- best-fit (default): the smallest free run which can contain the memory blocks, long free runs are kept for bigger requests
+		//	- first-fit: the lowest free run which can contain the memory blocks (kept for comparison, see H1MemoryBenchmark::RunBlockPlacement)
+		enum BlockPlacement
+		{
+			BlockPlacement_BestFit = 0,
+			BlockPlacement_FirstFit,
 		};
 
+		// it is supposed to be set at initialization (before the arena is used)
+		void SetBlockPlacement(BlockPlacement InPlacement) { Placement = InPlacement; }
+		BlockPlacement GetBlockPlacement() const { return Placement; }
+
+		// how the memory block containing the address is backed (nullptr or not arena memory returns BlockPage_NotCommitted)
+		BlockPageType GetMemoryBlockPageType(const void* Address) const;
+
+		// memory statistics
+		//	- reserved size is the address range taken by pages, committed size is what is really backed by physical memory
+		int64 GetReservedSize() const { return ReservedSize; }
+		int64 GetCommittedSize() const { return CommittedSize; }
+		BackingType GetBackingType() const { return Backing; }
+		bool IsVirtualMemoryBacked() const { return Backing == VirtualMemory || Backing == HugePage; }
+
+		// committed memory block counts by BlockPageType
+		int64 GetRegularBlockCount() const { return RegularBlockCount; }
+		int64 GetHugeExplicitBlockCount() const { return HugeExplicitBlockCount; }
+		int64 GetHugeTransparentBlockCount() const { return HugeTransparentBlockCount; }
+
+		// magazine depot statistics
+		//	- hit: thread-local magazine is exchanged with full (or empty) magazine in depot
+		//	- miss: depot has no magazine to exchange, so memory blocks are filled from (or flushed to) memory pages
+		int64 GetDepotHitCount() const { return DepotHitCount; }
+		int64 GetDepotMissCount() const { return DepotMissCount; }
+
+		// purge parameters (returning idle memory blocks to OS)
+		//	- memory block freed longer than DecayMilliseconds is decommitted (madvise(MADV_DONTNEED) or MEM_DECOMMIT)
+		//	- hysteresis: purge starts when free committed size goes over PurgeStartSize, and stops when it reaches RetainSize
+		struct PurgeParams
+		{
+			PurgeParams()
+				: DecayMilliseconds(10 * 1000)
+				, PurgeStartSize(64 * MEMORY_BLOCK_SIZE)
+				, RetainSize(16 * MEMORY_BLOCK_SIZE)
+			{}
+
+			uint64 DecayMilliseconds;
+			int64 PurgeStartSize;
+			int64 RetainSize;
+		};
+
+		void SetPurgeParams(const PurgeParams& InParams) { PurgeConfig = InParams; }
+		const PurgeParams& GetPurgeParams() const { return PurgeConfig; }
+
+		// purge idle memory blocks
+		//	- it is supposed to be called per-frame (or from background thread), it returns immediately if other thread is purging
+		//	- bForce ignores decay window and hysteresis (e.g. after level unloading)
+		//	- fully empty page whose memory blocks are all decommitted is unmapped (except for the last page of its list)
+		//	  its page table entry is reused by new page after no thread is looping pages which could see it
+		//	- only for virtual memory backed arena, returns purged size
+		int64 PurgeMemoryBlocks(bool bForce = false);
+
+		// purge statistics
+		int64 GetFreeCommittedSize() const { return FreeCommittedSize; }
+		int64 GetPurgeCount() const { return PurgeCount; }
+		int64 GetPurgedBlockCount() const { return PurgedBlockCount; }
+		int64 GetPurgedSize() const { return PurgedSize; }
+		uint64 GetLastPurgeTime() const { return LastPurgeTime; }
+		int64 GetRetiredPageCount() const { return RetiredPageCount; }
+
+		// tag budget
+		//	- budget is bytes of memory blocks (and large blocks) handed out for the tag, zero means unlimited
+		//	- soft budget: callback is fired, but the allocation succeeds anyway
+		//	- hard budget: callback is fired, and the allocation fails when the callback couldn't release enough memory
+		struct TagBudget
+		{
+			TagBudget()
+				: BudgetSize(0)
+				, bHardBudget(false)
+				, Callback(nullptr)
+				, UserData(nullptr)
+			{}
+
+			int64 BudgetSize;
+			bool bHardBudget;
+			OverBudgetCallback Callback;
+			void* UserData;
+		};
+
+		// it is supposed to be set at initialization (before the tag is used)
+		void SetTagBudget(MemoryTag InTag, const TagBudget& InBudget) { SubArenas[InTag].Budget = InBudget; }
+		const TagBudget& GetTagBudget(MemoryTag InTag) const { return SubArenas[InTag].Budget; }
+
+		// tag statistics
+		int64 GetTagUsedSize(MemoryTag InTag) const { return SubArenas[InTag].UsedSize; }
+		int64 GetTagPageCount(MemoryTag InTag) const { return SubArenas[InTag].PageCount; }
+		int64 GetTagOverBudgetCount(MemoryTag InTag) const { return SubArenas[InTag].OverBudgetCount; }
+		int64 GetTagAllocFailCount(MemoryTag InTag) const { return SubArenas[InTag].AllocFailCount; }
+
+		// warm-up (prefaulting)
+		//	- pages are created ahead, and memory blocks are committed and faulted in ahead per tag, so the first frame hits committed memory
+		//	- it is supposed to be called once from low priority background thread right after engine initialization
+		//	- prefaulted memory blocks are handed back as free committed blocks, so they are purge candidates like other free blocks
+		//	  (keep warm-up blocks under PurgeParams::PurgeStartSize not to be decommitted after decay)
+		struct WarmUpParams
+		{
+			WarmUpParams()
+				: NumaNode(0)
+			{
+				for (int32 Tag = 0; Tag < MemoryTag_Count; ++Tag)
+				{
+					PageCounts[Tag] = 0;
+					BlockCounts[Tag] = 0;
+				}
+			}
+
+			// pages in the sub-arena (including already existing pages)
+			int32 PageCounts[MemoryTag_Count];
+			// memory blocks to commit and prefault
+			int32 BlockCounts[MemoryTag_Count];
+			// NUMA node of the thread which will use the memory (warm-up thread could run on other node)
+			int32 NumaNode;
+		};
+
+		struct WarmUpReport
+		{
+			int32 PageCounts[MemoryTag_Count];
+			int32 BlockCounts[MemoryTag_Count];
+			// faulted in size (memory blocks)
+			int64 PrefaultedSize;
+			int64 ElapsedNanoseconds;
+		};
+
+		void WarmUp(const WarmUpParams& InParams);
+		// returns false until WarmUp is finished
+		bool GetWarmUpReport(WarmUpReport& OutReport) const;
+
+		// persistent image (BackingType::PersistentFile)
+		//	- memory pages are mapped from the file at FixedBaseAddress (aligned to MEMORY_PAGE_SIZE), file is [image header][page 0][page 1]...
+		//	- reopening the image restores all pages (headers and alloc bit masks are in the pages), so restarted process gets previous state
+		//	- when the address is taken, the image is mapped to other address (relocated); memory should be addressed by offset then
+		//	- large blocks are not persisted
+		//	- it should be opened before any allocation, and checkpoint should be called when no thread is allocating
+		bool OpenPersistentImage(const char* FilePath, int64 MaxPageCount, byte* FixedBaseAddress);
+		// flush the image to the file
+		bool CheckpointPersistentImage();
+		// unmap the image (it doesn't checkpoint)
+		void ClosePersistentImage();
+
+		bool IsPersistentImageRelocated() const { return bPersistentRelocated; }
+		// offset addressing (relative to the first page in the image)
+		int64 GetPersistentOffset(const void* Address) const;
+		byte* GetPersistentAddress(int64 Offset) const;
+		// persistent roots to find the data in restarted process (offset, -1 means not set)
+		void SetPersistentRoot(int32 RootIndex, int64 Offset);
+		int64 GetPersistentRoot(int32 RootIndex) const;
+
+		enum
+		{
+			MAX_PERSISTENT_ROOT_COUNT = 16,
+		};
+
+		// large block statistics
+		//	- count and size are for living large blocks (size is the mapped size)
+		//	- remap/copy count how ReallocateLargeBlock resized the large block
+		int64 GetLargeBlockCount() const { return LargeBlockCount; }
+		int64 GetLargeBlockSize() const { return LargeBlockSize; }
+		int64 GetLargeAllocCount() const { return LargeAllocCount; }
+		int64 GetLargeRemapCount() const { return LargeRemapCount; }
+		int64 GetLargeCopyCount() const { return LargeCopyCount; }
+
+		// telemetry
+		//	- counters are always collected (including FINAL_RELEASE), each thread updates its own slot and they are aggregated on read
+		//	- peak is tracked on page level, so memory blocks cached in magazines are counted as in use
+		enum
+		{
+			// index is free run length (contiguous free memory blocks), so whole free page is the last index
+			FREE_RUN_HISTOGRAM_SIZE = MEMORY_PAGE_SIZE / MEMORY_BLOCK_SIZE + 1,
+		};
+
+		struct ArenaStats
+		{
+			int64 PageCount;
+			// handed out to callers (AllocateMemoryBlock(s) - DeallocateMemoryBlock(s))
+			int64 BlockInUseCount;
+			// allocated from memory pages (including magazines)
+			int64 PageBlockInUseCount;
+			int64 PeakPageBlockInUseCount;
+
+			int64 AllocCount;
+			int64 FreeCount;
+			int64 AllocBlockCount;
+			int64 FreeBlockCount;
+			// per second, since previous GetStats call
+			float AllocRate;
+			float FreeRate;
+
+			// page creation lock contention (sub-arena locks and MemoryArenaSyncObject)
+			int64 LockCount;
+			int64 LockContendedCount;
+			int64 LockSpinNanoseconds;
+
+			// deferred free batches
+			int64 DeferredFlushCount;
+			int64 DeferredFreeCount;
+			int64 DeferredMaxBatchSize;
+			// from the first deferred free in the batch to its flush
+			int64 DeferredFlushLatencyNanoseconds;
+			int64 DeferredMaxFlushLatencyNanoseconds;
+
+			// free runs of all pages (fragmentation)
+			int64 FreeRunHistogram[FREE_RUN_HISTOGRAM_SIZE];
+		};
+
+		struct PageStats
+		{
+			uint32 TagId;
+			MemoryTag Tag;
+			int32 NumaNode;
+			int32 UsedBlockCount;
+			int32 LongestFreeRun;
+			// 0 (no fragmentation) ~ 1 (free memory blocks are all scattered)
+			float Fragmentation;
+			int32 FreeRunHistogram[FREE_RUN_HISTOGRAM_SIZE];
+		};
+
+		// aggregate the stats; rates are measured between calls, so it is supposed to be called by one thread (e.g. per-frame)
+		void GetStats(ArenaStats& OutStats);
+		// fill stats of pages up to MaxPageCount, returns the number of filled pages
+		int32 GetPageStats(PageStats* OutPageStats, int32 MaxPageCount) const;
+
 	protected:
 		// the memory header that includes all information for memory allocation
 		struct MemoryHeader
 		{
 			// memory header should be less than 32KB (total size)
 			byte Offset; // memory block offset
+			byte BlockCount; // contiguous block count, only valid for the first memory block of allocation
 		};
 
 		// the wrapper of actual memory data
@@ -111,68 +528,78 @@ namespace Memory
 				- memory page contains memory headers and memory blocks
 				- this memory page is controlled by memory arena
 				- you can think of this memory page as virtual memory page in OS
+				- memory page is the metadata out of band (entry of the page table), memory blocks don't contain any metadata
 		*/
-		struct MemoryPage
+		struct alignas(64) MemoryPage
 		{
 			MemoryPage() {}
 			~MemoryPage() {}
 
 			enum
 			{
-				// we have 63 memory block counts for actual usage; memory page provide us total 126MB to use
-				MEMORY_BLOCK_COUNT = 63,				
+				// we have 64 memory block counts for actual usage; memory page provide us total 128MB to use
+				MEMORY_BLOCK_COUNT = MEMORY_PAGE_SIZE / MEMORY_BLOCK_SIZE,
 			};
 
-			// last memory block is sued for headers and additional properties, so the block make it empty
-			const uint64 ALLOC_BIT_MASK_FULL = (uint64)(0xFFFFFFFFFFFFFFFF >> 1);
+			static const uint64 ALLOC_BIT_MASK_FULL = (uint64)0xFFFFFFFFFFFFFFFF;
 			
-			// tagger for memory page 
-			//	- has additional information for this memory page
-			//	- we can use this tag for indicator to distinguish the usages
-			//	- tag is contained as unique id
-			//		- like Default + N ( N < Default2 for example)
-			enum Tag
-			{
-				Default = 0,
-				// Default2 = 1 << 2, ... etc
-			};
-
-			// memory page layout to align memory blocks below union structure
+			// memory page layout (page table entry)
+			//	- page table entries are contiguous, so looping pages only touches this small metadata (not 128MB strided memory blocks)
+			//	- properties to loop pages (alloc bit mask, longest free run and next page) are in the first cache line
 			struct MemoryPageLayout
 			{
-				MemoryBlock		MemoryBlocks[MEMORY_BLOCK_COUNT];
-
-				// below section should be less than 2MB (MEMORY_BLOCK_SIZE)
-				MemoryHeader	Headers[MEMORY_BLOCK_COUNT];	// memory headers
 				// properties
 				// 1. alloc bit mask
-				uint64			AllocBitMask;
-				// 2. singly linked list (tracking next page and next free page)
-				SGD::unique_ptr<MemoryPage> NextPage;
-				MemoryPage*	NextFreePage;
-				// 3. unique id
+				//	- memory blocks are allocated/deallocated lock-free by CAS on this bit mask
+				SGD::atomic<uint64> AllocBitMask;
+				//	- longest free run summary of alloc bit mask (hint to skip the page without scanning)
+				//	- it is updated after alloc bit mask is changed, so it could be stale for a moment
+				SGD::atomic<int32> LongestFreeRun;
+				// 2. singly linked list (tracking next page)
+				//	- page is not owned by unique_ptr, its memory is released differently by BackingType
+				//	- it is set before the page is published to PageHeads, and only changed under the lock of sub-arena when the next page is retired (read lock-free)
+				SGD::atomic<MemoryPage*> NextPage;
+				// 3. memory blocks of the page (aligned to MEMORY_PAGE_SIZE)
+				MemoryBlock*	MemoryBlocks;
+				// 4. unique id (index of the page table)
 				//	- memory page cannot over the range of uint32 (it will over TB...)
 				uint32			TagId;
-			};
-
-			union
-			{
-				// memory page layout
-				MemoryPageLayout Layout;
+				// 5. NUMA node which the page is bound to
+				int32			NumaNode;
+				// 6. memory tag (sub-arena) which owns the page
+				//	- we can use this tag for indicator to distinguish the usages
+				MemoryTag		Tag;
+				//	- linked list of retired page table entries (NextPage is kept for the threads still looping the retired page)
+				MemoryPage*		NextRetiredPage;
+				// 7. commit bit mask (only meaningful for BackingType::VirtualMemory and HugePage)
+				//	- once a memory block is committed, it stays committed when it is reused
+				//	- each block is committed by the thread which owns it, so bits are set with atomic or
+				SGD::atomic<uint64> CommitBitMask;
+				//	- huge page bit masks; the block is backed by regular pages if neither bit is set
+				SGD::atomic<uint64> HugeExplicitBitMask;
+				SGD::atomic<uint64> HugeTransparentBitMask;
 
-				// memory blocks
-				//	- last memory block is used for the container for memory headers
-				MemoryBlock MemoryBlocks[MEMORY_BLOCK_COUNT + 1];
+				MemoryHeader	Headers[MEMORY_BLOCK_COUNT];	// memory headers
+				// the time when the memory block is freed (used for purge decay)
+				uint64			FreeTimes[MEMORY_BLOCK_COUNT];
 			};
 
+			// memory page layout
+			MemoryPageLayout Layout;
+
 			// methods
-			bool IsFull() const { return Layout.AllocBitMask != ALLOC_BIT_MASK_FULL; }
+			bool IsFull() const { return Layout.AllocBitMask.load(std::memory_order_relaxed) == ALLOC_BIT_MASK_FULL; }
+
+			// whether the page could have the contiguous free memory blocks (by longest free run summary)
+			bool CanAllocate(int32 InBlockCount) const { return Layout.LongestFreeRun.load(std::memory_order_relaxed) >= InBlockCount; }
+			// recalculate longest free run summary from alloc bit mask
+			void UpdateLongestFreeRun();
 
-			void SetNextPage(SGD::unique_ptr<MemoryPage>& NewPage) { Layout.NextPage = SGD::move(NewPage); }
-			void SetNextFreePage(MemoryPage* NewFreePage) { Layout.NextFreePage = NewFreePage; }
+			BlockPageType GetBlockPageType(int32 Offset) const;
 
-			MemoryPage* GetNextPage() { return Layout.NextPage.get(); }
-			MemoryPage* GetNextFreePage() { return Layout.NextFreePage; }
+			void SetNextPage(MemoryPage* NewPage) { Layout.NextPage.store(NewPage); }
+
+			MemoryPage* GetNextPage() { return Layout.NextPage.load(std::memory_order_acquire); }
 
 			// allocate/deallocate (for internal methods for MemoryPage)
 
@@ -181,11 +608,17 @@ namespace Memory
 			struct AllocInput
 			{
 				AllocInput()
-					: BlockCount(0)
+					: BlockCount(0), NumaNode(0), Tag(MemoryTag_Default), Placement(BlockPlacement_BestFit)
 				{}
 
 				// requested memory block count
 				int32 BlockCount; 
+				// NUMA node to allocate from
+				int32 NumaNode;
+				// sub-arena to allocate from
+				MemoryTag Tag;
+				// how to place the memory blocks in the page
+				BlockPlacement Placement;
 			};
 
 			struct AllocOutput
@@ -208,45 +641,484 @@ namespace Memory
 			struct DeallocInput
 			{
 				DeallocInput()
-					: TagId(-1), Offset(-1), Count(-1)
+					: BaseAddress(nullptr), TagId(-1), Offset(-1), Count(-1), Tag(MemoryTag_Default)
 				{}
 
+				// base address of the first memory block (page is looked up by this address)
+				byte* BaseAddress;
+
 				// memory page id (tag id)
+				//	- only used for validation
 				uint32 TagId;
 
 				// memory block offset and count
 				int32 Offset;
 				int32 Count;
+
+				// resolved by the memory page
+				MemoryTag Tag;
 			};
 
 			AllocOutput Allocate(const AllocInput& Params);
 			void Deallocate(const DeallocInput& Params);
+			// deallocate all memory blocks of the bits at once (deferred free batch)
+			void DeallocateBits(uint64 InAllocBits);
+
+			// count free runs by its length (index of histogram), histogram should be FREE_RUN_HISTOGRAM_SIZE
+			void GetFreeRunHistogram(int32* OutFreeRunHistogram) const;
+
+			// mark one free memory block as allocated without updating headers (used for purge)
+			bool ClaimFreeBlock(int32 InOffset);
+
+			// memory block offset for the address in this page
+			int32 GetBlockOffset(const void* Address) const { return (int32)(((const byte*)Address - (const byte*)Layout.MemoryBlocks) / MEMORY_BLOCK_SIZE); }
+
+			// bit mask for the memory block range
+			static uint64 GetAllocBits(int32 InOffset, int32 InCount = 1);
 
 		protected:
 			// internal helper methods
 
-			// get available memory block index
-			int32 GetAvailableBlockIndex(int32 InBlockCount = 1);
-			// marking alloc bits with Value
-			void MarkAllocBits(bool InValue, int32 InOffset, int32 InCount = 1);
+			// get available memory block index from the snapshot of alloc bit mask
+			//	- best-fit: the smallest free run which can contain the memory blocks (to keep long free runs intact)
+			//	- first-fit: the lowest offset which can contain the memory blocks
+			static int32 GetAvailableBlockIndex(uint64 InAllocBitMask, int32 InBlockCount = 1, BlockPlacement InPlacement = BlockPlacement_BestFit);
+			// bit-parallel run search: bit N is set when N ~ N + RunLength - 1 bits are all set in FreeBitMask (shift-and-AND folding)
+			static uint64 GetFreeRunStartMask(uint64 FreeBitMask, int32 RunLength);
+			static int32 CalculateLongestFreeRun(uint64 FreeBitMask);
 			// validation checking
 			void ValidateAllocBits(bool InValue, int32 InOffset, int32 InCount = 1);
 		};
 
+		/*
+			Memory Page Directory
+				- memory blocks of the page are aligned to MEMORY_PAGE_SIZE, so the address bits above PAGE_SHIFT is the unique page index
+				- two-level radix table (like OS page table) maps the page index to the memory page
+				- register/unregister is called under MemoryArenaSyncObject, lookup is lock-free
+		*/
+		class MemoryPageDirectory
+		{
+		public:
+			enum
+			{
+				PAGE_SHIFT = 27,	// 1 << 27 == MEMORY_PAGE_SIZE
+				ADDRESS_BITS = 48,	// x64 user-space virtual address
+				LEAF_BITS = 10,
+				ROOT_BITS = ADDRESS_BITS - PAGE_SHIFT - LEAF_BITS,
+				LEAF_COUNT = 1 << LEAF_BITS,
+				ROOT_COUNT = 1 << ROOT_BITS,
+			};
+
+			MemoryPageDirectory();
+			~MemoryPageDirectory();
+
+			void Register(MemoryPage* Page);
+			void Unregister(MemoryPage* Page);
+			MemoryPage* Find(const void* Address) const;
+
+		protected:
+			struct MemoryPageDirectoryLeaf
+			{
+				SGD::atomic<MemoryPage*> Pages[LEAF_COUNT];
+			};
+
+			SGD::atomic<MemoryPageDirectoryLeaf*> Roots[ROOT_COUNT];
+		};
+
+		/*
+			Block Magazine
+				- motivated from Bonwick's magazine allocator (Magazines and Vmem)
+				- each thread caches single memory blocks with two magazines (loaded and previous)
+				- when both magazines are empty (or full), whole magazine is exchanged with depot in a batch
+				- only single memory block (AllocateMemoryBlock) goes through magazines
+		*/
+		struct BlockMagazine
+		{
+			enum
+			{
+				MAGAZINE_SIZE = 4,	// 8MB cached per magazine
+			};
+
+			BlockMagazine()
+				: Count(0), Next(nullptr)
+			{}
+
+			bool IsEmpty() const { return Count == 0; }
+			bool IsFull() const { return Count == MAGAZINE_SIZE; }
+
+			void Push(byte* InAddress) { Blocks[Count++] = InAddress; }
+			byte* Pop() { return Blocks[--Count]; }
+
+			// base addresses of cached memory blocks
+			byte* Blocks[MAGAZINE_SIZE];
+			int32 Count;
+
+			// linked list in depot
+			BlockMagazine* Next;
+		};
+
+		// thread-local magazines
+		struct BlockMagazineCache
+		{
+			BlockMagazineCache()
+				: Owner(nullptr), Loaded(nullptr), Previous(nullptr), NextBound(nullptr)
+			{}
+
+			// return cached memory blocks when the thread is terminated
+			~BlockMagazineCache();
+
+			// magazine cache is bound to the first memory arena using it in the thread
+			H1MemoryArena* Owner;
+
+			BlockMagazine* Loaded;
+			BlockMagazine* Previous;
+
+			// linked list of magazine caches bound to the owner memory arena (protected by owner's DepotSyncObject)
+			BlockMagazineCache* NextBound;
+		};
+
+		enum
+		{
+			// full magazines more than this count in depot are flushed to memory pages
+			DEPOT_FULL_MAGAZINE_LIMIT = 16,
+		};
+
+		// nullptr after thread-local magazine cache is destroyed (thread exit)
+		static BlockMagazineCache* GetThreadMagazineCache();
+		// get bounded thread-local magazine cache (nullptr if the thread is bound to other memory arena)
+		BlockMagazineCache* GetMagazineCache();
+
+		// allocate/deallocate single memory block through magazines
+		byte* AllocateFromMagazine(BlockMagazineCache* Cache);
+		void DeallocateToMagazine(BlockMagazineCache* Cache, byte* InAddress);
+
+		// batch operations between magazine and memory pages (MemoryTag_Default)
+		void FillMagazine(BlockMagazine* Magazine);
+		void FlushMagazine(BlockMagazine* Magazine);
+
+		// unlink the magazine cache from bound list (caller holds DepotSyncObject)
+		void UnbindMagazineCache(BlockMagazineCache* Cache);
+
+		// destroy all magazines in depot and unbind all threads' magazine caches
+		void DestroyMagazines();
+
+		// thread-local deferred free queue
+		struct DeferredFreeQueue
+		{
+			DeferredFreeQueue()
+				: Owner(nullptr), Count(0), FrameNumber(0), FirstDeferTime(0), NextBound(nullptr)
+			{}
+
+			// flush deferred memory blocks when the thread is terminated
+			~DeferredFreeQueue();
+
+			// deferred free queue is bound to the first memory arena using it in the thread
+			H1MemoryArena* Owner;
+
+			// base addresses of deferred memory blocks
+			byte* Addresses[DEFERRED_FREE_QUEUE_SIZE];
+			int32 Count;
+
+			// frame and time of the first deferred free in the queue
+			uint64 FrameNumber;
+			uint64 FirstDeferTime;
+
+			// the queue is flushed by other threads at the frame boundary
+			SGD::Thread::H1CriticalSection SyncObject;
+
+			// linked list of deferred free queues bound to the owner memory arena (protected by owner's BoundQueueSyncObject)
+			DeferredFreeQueue* NextBound;
+		};
+
+		// nullptr after thread-local deferred free queue is destroyed (thread exit)
+		static DeferredFreeQueue* GetThreadDeferredFreeQueue();
+		// get bounded thread-local deferred free queue (nullptr if the thread is bound to other memory arena)
+		DeferredFreeQueue* GetDeferredFreeQueue();
+		// hand back deferred memory blocks to memory pages in a batch (caller holds the queue's SyncObject)
+		void FlushDeferredFreeQueue(DeferredFreeQueue* Queue);
+		// unlink the deferred free queue from bound list (caller holds BoundQueueSyncObject)
+		void UnbindDeferredFreeQueue(DeferredFreeQueue* Queue);
+		// flush and unbind all threads' deferred free queues
+		void ReleaseDeferredFreeQueues();
+
+		// create memory block handle from its base address
+		H1MemoryBlock CreateMemoryBlock(byte* InAddress) const;
+
+		// per-thread telemetry counters
+		//	- aligned to cache line not to be shared with other threads' slots
+		struct alignas(64) ThreadStats
+		{
+			ThreadStats()
+				: AllocCount(0), FreeCount(0), AllocBlockCount(0), FreeBlockCount(0)
+				, LockCount(0), LockContendedCount(0), LockSpinNanoseconds(0)
+			{}
+
+			SGD::atomic<int64> AllocCount;
+			SGD::atomic<int64> FreeCount;
+			SGD::atomic<int64> AllocBlockCount;
+			SGD::atomic<int64> FreeBlockCount;
+			SGD::atomic<int64> LockCount;
+			SGD::atomic<int64> LockContendedCount;
+			SGD::atomic<int64> LockSpinNanoseconds;
+		};
+
+		enum
+		{
+			// threads more than this count share the slot
+			MAX_THREAD_STATS_COUNT = 64,
+		};
+
+		ThreadStats& GetThreadStats();
+		void RecordAlloc(int64 BlockCount);
+		void RecordFree(int64 BlockCount, int64 FreeCount = 1);
+		// page level block count (including peak)
+		void RecordPageAlloc(int64 BlockCount);
+		// lock page creation lock with measuring the contention
+		void LockSyncObject(SGD::Thread::H1CriticalSection& SyncObject);
+
+		// reserve/release the tag budget
+		//	- it fires over budget callback, and returns false when the tag is over its hard budget
+		bool ReserveTagBudget(MemoryTag InTag, int64 Size);
+		void ReleaseTagBudget(MemoryTag InTag, int64 Size);
+
+		enum
+		{
+			// how many times the allocation is retried after over budget callback released the memory
+			MAX_OVER_BUDGET_RETRY_COUNT = 4,
+		};
+
+		// persistent image header (at the beginning of the file)
+		struct PersistentImageHeader
+		{
+			uint64 Magic;
+			uint32 Version;
+			// to validate the layout of memory page
+			uint32 PageSize;
+			int64 MaxPageCount;
+			int64 PageCount;
+			// base address of pages when the image is mapped last time
+			uint64 BaseAddress;
+			int64 CheckpointCount;
+			int64 Roots[MAX_PERSISTENT_ROOT_COUNT];
+		};
+
+		static const uint64 PERSISTENT_IMAGE_MAGIC = 0x31414E4552413148ull; // "H1ARENA1"
+		enum
+		{
+			PERSISTENT_IMAGE_VERSION = 4,
+			// page table is in the image header region after the image header
+			PERSISTENT_PAGE_TABLE_OFFSET = 64 * 1024,
+			// memory pages start after the image header region (it is sparse, only written parts of the page table take the space)
+			PERSISTENT_IMAGE_HEADER_SIZE = 8 * MEMORY_BLOCK_SIZE,
+		};
+
+		// restore memory pages of reopened image
+		void RestorePersistentPages();
+
+		// NUMA node initialization and preferred node for current thread
+		void InitializeNumaNodes();
+		int32 GetPreferredNumaNode() const;
+
+		// page table (memory page metadata out of band)
+		//	- indexed by unique id (TagId), the address range is reserved at once and committed on demand
+		//	- persistent image has its page table in the image header region instead
+		enum
+		{
+			MAX_PAGE_COUNT = 16 * 1024, // 2TB of memory pages
+		};
+
+		void InitializePageTable();
+		void DestroyPageTable();
+		// page table entry for new page (called under MemoryArenaSyncObject)
+		MemoryPage* CommitPageTableEntry(uint32 TagId);
+
 		// allocating new page
-		MemoryPage* AllocatePage();
+		MemoryPage* AllocatePage(int32 NumaNode, MemoryTag InTag);
 		// deallocating all pages
 		void DeallocateAllPages();
+		// commit memory blocks which are not committed yet (BackingType::VirtualMemory and HugePage)
+		void CommitMemoryBlocks(MemoryPage* Page, int32 Offset, int32 Count);
+		// decommit one free memory block (it should be claimed by the caller)
+		void DecommitMemoryBlock(MemoryPage* Page, int32 Offset);
+		// unlink and unmap the fully empty and decommitted page (called by the purging thread)
+		bool RetirePage(MemoryPage* Page);
+		// retired page table entries become reusable when no thread is looping pages (called under MemoryArenaSyncObject)
+		void ReclaimRetiredPages();
+
+		// threads looping page lists lock-free
+		//	- retired page could be seen by the threads which started looping before it is unlinked
+		struct PageWalkScope
+		{
+			PageWalkScope(const H1MemoryArena* InArena) : Arena(InArena) { Arena->PageWalkerCount.fetch_add(1); }
+			~PageWalkScope() { Arena->PageWalkerCount.fetch_sub(1); }
+
+			const H1MemoryArena* Arena;
+		};
 		// allocate internal
+		//	- lock-free; the lock of sub-arena is only taken when new page should be created
 		MemoryPage::AllocOutput AllocateInternal(const MemoryPage::AllocInput& Input);
-		void DeallocateInternal(const MemoryPage::DeallocInput& Input);
+		// try to allocate from existing pages of the NUMA node in the sub-arena (lock-free)
+		MemoryPage* TryAllocateFromPages(const MemoryPage::AllocInput& Input, int32 NumaNode, MemoryPage::AllocOutput& Output);
+		void DeallocateInternal(MemoryPage::DeallocInput& Input);
+
+		// large block table entry
+		//	- free entries are linked by NextFreeIndex, so both allocation and deallocation are O(1)
+		struct LargeBlockEntry
+		{
+			byte* BaseAddress;
+			// mapped size (aligned to MEMORY_BLOCK_SIZE)
+			int64 MappedSize;
+			int32 NextFreeIndex;
+			MemoryTag Tag;
+		};
 
-		// memory pages
-		SGD::unique_ptr<MemoryPage> PageHead;
-		MemoryPage*	FreePageHead;
+		H1MemoryLargeBlock AllocateLargeBlockInternal(int64 Size, int32 NumaNode, MemoryTag InTag);
+		// map/unmap large block region
+		byte* MapLargeBlock(int64 MappedSize, int32 NumaNode);
+		void UnmapLargeBlock(byte* Address, int64 MappedSize);
+		// returns mapped size of the large block
+		int64 DeallocateLargeBlockInternal(int32 LargeBlockIndex);
+		// find large block index by base address (-1 if it is not large block)
+		int32 FindLargeBlockIndex(const void* Address);
+		void DeallocateAllLargeBlocks();
+
+		/*
+			Sub Arena
+				- memory pages of one memory tag
+				- pages are listed per NUMA node, new page is only pushed to the head (under SyncObject), so it can be looped lock-free
+				- free memory blocks are tracked by alloc bit masks of its own pages (pages are never shared between tags)
+		*/
+		struct SubArena
+		{
+			SubArena()
+				: UsedSize(0), PageCount(0), OverBudgetCount(0), AllocFailCount(0)
+			{}
+
+			SGD::atomic<MemoryPage*> PageHeads[MAX_NUMA_NODE_COUNT];
+			// page creation lock
+			SGD::Thread::H1CriticalSection SyncObject;
+
+			TagBudget Budget;
+			SGD::atomic<int64> UsedSize;
+
+			// statistics
+			SGD::atomic<int64> PageCount;
+			SGD::atomic<int64> OverBudgetCount;
+			SGD::atomic<int64> AllocFailCount;
+		};
+
+		SubArena SubArenas[MemoryTag_Count];
+
+		// NUMA
+		int32 NumaNodeCount;
+		bool bNumaRemoteFallback;
+		SGD::atomic<int64> NumaRemoteAllocCount;
+
+		// placement of memory blocks in the page
+		BlockPlacement Placement;
+
+		// address to memory page lookup
+		MemoryPageDirectory PageDirectory;
+
+		// page table
+		MemoryPage* PageTable;
+		int64 PageTableCommittedSize;
+
+		// memory page backing type
+		BackingType Backing;
+		// unique id for next allocated page
+		uint32 NextPageTagId;
+
+		// memory statistics
+		SGD::atomic<int64> ReservedSize;
+		SGD::atomic<int64> CommittedSize;
+		SGD::atomic<int64> RegularBlockCount;
+		SGD::atomic<int64> HugeExplicitBlockCount;
+		SGD::atomic<int64> HugeTransparentBlockCount;
 
 		// thread synchronization
+		//	- page registration shared by all sub-arenas (page directory and unique id)
 		SGD::Thread::H1CriticalSection MemoryArenaSyncObject;
+
+		// magazine depot
+		BlockMagazine* DepotFullHead;
+		BlockMagazine* DepotEmptyHead;
+		int32 DepotFullCount;
+		// magazine caches bound to this memory arena, unbound when the memory arena is destroyed
+		BlockMagazineCache* BoundCacheHead;
+		SGD::Thread::H1CriticalSection DepotSyncObject;
+
+		// magazine depot statistics
+		SGD::atomic<int64> DepotHitCount;
+		SGD::atomic<int64> DepotMissCount;
+
+		// purge
+		PurgeParams PurgeConfig;
+		// committed but free memory blocks (purge candidates)
+		SGD::atomic<int64> FreeCommittedSize;
+		// only one thread purges at a time
+		SGD::atomic<bool> bPurging;
+
+		// purge statistics
+		SGD::atomic<int64> PurgeCount;
+		SGD::atomic<int64> PurgedBlockCount;
+		SGD::atomic<int64> PurgedSize;
+		SGD::atomic<uint64> LastPurgeTime;
+
+		// page retirement
+		mutable SGD::atomic<int32> PageWalkerCount;
+		// unlinked pages waiting for page walkers, and reusable page table entries (protected by MemoryArenaSyncObject)
+		MemoryPage* RetiredPageHead;
+		MemoryPage* FreePageEntryHead;
+		SGD::atomic<int64> RetiredPageCount;
+
+		// large block table
+		LargeBlockEntry LargeBlocks[MAX_LARGE_BLOCK_COUNT];
+		int32 LargeBlockFreeHead;
+		// entries never used yet are taken from the end (no need to initialize the table)
+		int32 LargeBlockUsedCount;
+		SGD::Thread::H1CriticalSection LargeBlockSyncObject;
+
+		// large block statistics
+		SGD::atomic<int64> LargeBlockCount;
+		SGD::atomic<int64> LargeBlockSize;
+		SGD::atomic<int64> LargeAllocCount;
+		SGD::atomic<int64> LargeRemapCount;
+		SGD::atomic<int64> LargeCopyCount;
+
+		// deferred free
+		//	- deferred free queues bound to this memory arena, unbound when the memory arena is destroyed
+		DeferredFreeQueue* BoundQueueHead;
+		SGD::Thread::H1CriticalSection BoundQueueSyncObject;
+		SGD::atomic<uint64> DeferredFreeFrame;
+		int32 DeferredFreeThreshold;
+		// deferred free statistics
+		SGD::atomic<int64> DeferredFlushCount;
+		SGD::atomic<int64> DeferredFreeCount;
+		SGD::atomic<int64> DeferredMaxBatchSize;
+		SGD::atomic<int64> DeferredFlushLatencyNanoseconds;
+		SGD::atomic<int64> DeferredMaxFlushLatencyNanoseconds;
+
+		// telemetry
+		ThreadStats ThreadStatsSlots[MAX_THREAD_STATS_COUNT];
+		SGD::atomic<int64> PageCount;
+		SGD::atomic<int64> PageBlockInUseCount;
+		SGD::atomic<int64> PeakPageBlockInUseCount;
+		// previous GetStats for rates
+		uint64 LastStatsTime;
+		int64 LastStatsAllocCount;
+		int64 LastStatsFreeCount;
+
+		// persistent image
+		int64 PersistentFileHandle;
+		PersistentImageHeader* PersistentHeader;
+		byte* PersistentBaseAddress;
+		int64 PersistentMaxPageCount;
+		bool bPersistentRelocated;
+
+		// warm-up (report is published by bWarmUpDone)
+		WarmUpReport LastWarmUpReport;
+		SGD::atomic<bool> bWarmUpDone;
 	};
 }
 }
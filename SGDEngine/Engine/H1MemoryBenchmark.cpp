@@ -0,0 +1,448 @@
+#include "H1EnginePrivate.h"
+#include "H1MemoryBenchmark.h"
+
+// memory logger
+#include "H1MemoryLogger.h"
+
+// block allocator (page size benchmark)
+#include "H1BlockAllocPolicy.h"
+
+// transient allocators (fan-out benchmark)
+#include "H1SharedLinearAllocator.h"
+#include "H1MemStack.h"
+
+using namespace SGD::Memory;
+using namespace SGD::Platform::Util;
+
+// deterministic random sequence (LCG), every case of the benchmark replays the same sequence
+class H1BenchmarkRandom
+{
+public:
+	H1BenchmarkRandom(uint64 InSeed)
+		: State(InSeed)
+	{}
+
+	uint32 Next()
+	{
+		State = State * 6364136223846793005ull + 1442695040888963407ull;
+		return (uint32)(State >> 33);
+	}
+
+	// [0, InRange)
+	int32 Next(int32 InRange) { return (int32)(Next() % (uint32)InRange); }
+
+protected:
+	uint64 State;
+};
+
+/*
+	page size benchmark
+		- object-size mix: 16B (30%), 32B (25%), 64B (20%), 128B (12%), 256B (8%), 1KB (5%)
+		- live set of PAGE_SIZE_OBJECT_COUNT objects (about 32MB), PAGE_SIZE_CHURN_COUNT of free and allocate pairs
+*/
+enum
+{
+	PAGE_SIZE_SIZE_CLASS_COUNT = 6,
+	PAGE_SIZE_OBJECT_COUNT = 256 * 1024,
+	PAGE_SIZE_CHURN_COUNT = 1024 * 1024,
+};
+
+static const int32 GPageSizeSizeClassWeights[PAGE_SIZE_SIZE_CLASS_COUNT] = { 30, 25, 20, 12, 8, 5 };
+
+static int32 PickPageSizeSizeClass(H1BenchmarkRandom& Random)
+{
+	int32 Weight = Random.Next(100);
+	for (int32 SizeClass = 0; SizeClass < PAGE_SIZE_SIZE_CLASS_COUNT; ++SizeClass)
+	{
+		Weight -= GPageSizeSizeClassWeights[SizeClass];
+		if (Weight < 0)
+		{
+			return SizeClass;
+		}
+	}
+
+	return PAGE_SIZE_SIZE_CLASS_COUNT - 1;
+}
+
+// block allocator pools for each size class
+template <int32 PageSize>
+class H1PageSizeBenchmarkPools
+{
+public:
+	template <int32 DataSize>
+	using PoolType = H1BlockAllocPolicy<H1BlockAllocParams<DataSize>, H1DefaultAllocPagePolicy<PageSize> >;
+
+	byte* Allocate(int32 SizeClass)
+	{
+		switch (SizeClass)
+		{
+		case 0: return Pool16.Allocate(16);
+		case 1: return Pool32.Allocate(32);
+		case 2: return Pool64.Allocate(64);
+		case 3: return Pool128.Allocate(128);
+		case 4: return Pool256.Allocate(256);
+		default: return Pool1024.Allocate(1024);
+		}
+	}
+
+	void Deallocate(int32 SizeClass, byte* InPointer)
+	{
+		switch (SizeClass)
+		{
+		case 0: Pool16.Deallocate(InPointer); break;
+		case 1: Pool32.Deallocate(InPointer); break;
+		case 2: Pool64.Deallocate(InPointer); break;
+		case 3: Pool128.Deallocate(InPointer); break;
+		case 4: Pool256.Deallocate(InPointer); break;
+		default: Pool1024.Deallocate(InPointer); break;
+		}
+	}
+
+	int64 GetChunkSize()
+	{
+		int64 ChunkCount = Pool16.GetPagePolicy().GetChunkCount() + Pool32.GetPagePolicy().GetChunkCount() + Pool64.GetPagePolicy().GetChunkCount()
+			+ Pool128.GetPagePolicy().GetChunkCount() + Pool256.GetPagePolicy().GetChunkCount() + Pool1024.GetPagePolicy().GetChunkCount();
+		return ChunkCount * H1MemoryArena::MEMORY_BLOCK_SIZE;
+	}
+
+	int64 GetTotalPageSize()
+	{
+		return Pool16.GetTotalPageSize() + Pool32.GetTotalPageSize() + Pool64.GetTotalPageSize() + Pool128.GetTotalPageSize() + Pool256.GetTotalPageSize() + Pool1024.GetTotalPageSize();
+	}
+
+protected:
+	PoolType<16> Pool16;
+	PoolType<32> Pool32;
+	PoolType<64> Pool64;
+	PoolType<128> Pool128;
+	PoolType<256> Pool256;
+	PoolType<1024> Pool1024;
+};
+
+template <int32 PageSize>
+static void RunPageSizeCase(H1MemoryBenchmark::PageSizeResult& OutResult)
+{
+	SGD::Container::H1Array<byte*> Objects(PAGE_SIZE_OBJECT_COUNT, nullptr);
+	SGD::Container::H1Array<int32> SizeClasses(PAGE_SIZE_OBJECT_COUNT, 0);
+
+	H1BenchmarkRandom Random(0x5D6E);
+	int64 PeakChunkSize = 0;
+	int64 PeakPageSize = 0;
+
+	uint64 StartTime = appGetTimeNanoseconds();
+	{
+		H1PageSizeBenchmarkPools<PageSize> Pools;
+
+		// fill the live set (objects are touched like real usage)
+		for (int32 Index = 0; Index < PAGE_SIZE_OBJECT_COUNT; ++Index)
+		{
+			SizeClasses[Index] = PickPageSizeSizeClass(Random);
+			Objects[Index] = Pools.Allocate(SizeClasses[Index]);
+			Objects[Index][0] = (byte)Index;
+		}
+
+		// churn: replace random objects with new objects of random size class
+		for (int32 Count = 0; Count < PAGE_SIZE_CHURN_COUNT; ++Count)
+		{
+			int32 Index = Random.Next(PAGE_SIZE_OBJECT_COUNT);
+			Pools.Deallocate(SizeClasses[Index], Objects[Index]);
+
+			SizeClasses[Index] = PickPageSizeSizeClass(Random);
+			Objects[Index] = Pools.Allocate(SizeClasses[Index]);
+			Objects[Index][0] = (byte)Count;
+		}
+
+		// block allocator never returns its pages, so the size before freeing all is the peak
+		PeakChunkSize = Pools.GetChunkSize();
+		PeakPageSize = Pools.GetTotalPageSize();
+
+		// free all
+		for (int32 Index = 0; Index < PAGE_SIZE_OBJECT_COUNT; ++Index)
+		{
+			Pools.Deallocate(SizeClasses[Index], Objects[Index]);
+		}
+	}
+	uint64 EndTime = appGetTimeNanoseconds();
+
+	OutResult.PageSize = PageSize;
+	OutResult.ElapsedNanoseconds = (int64)(EndTime - StartTime);
+	OutResult.PeakChunkSize = PeakChunkSize;
+	OutResult.PeakPageSize = PeakPageSize;
+}
+
+void H1MemoryBenchmark::RunPageSize(PageSizeResult (&OutResults)[PAGE_SIZE_CASE_COUNT])
+{
+	RunPageSizeCase<4 * 1024>(OutResults[0]);
+	RunPageSizeCase<64 * 1024>(OutResults[1]);
+	RunPageSizeCase<1024 * 1024>(OutResults[2]);
+
+	h1MemDebugf("block allocator page size benchmark (%d objects, %d churns)", PAGE_SIZE_OBJECT_COUNT, PAGE_SIZE_CHURN_COUNT);
+	for (int32 Index = 0; Index < PAGE_SIZE_CASE_COUNT; ++Index)
+	{
+		const PageSizeResult& Result = OutResults[Index];
+		h1MemDebugf("\t%d KB page: %lld ms, peak chunks %lld KB, peak pages %lld KB", Result.PageSize / 1024, Result.ElapsedNanoseconds / 1000000, Result.PeakChunkSize / 1024, Result.PeakPageSize / 1024);
+	}
+}
+
+/*
+	block placement benchmark
+		- AllocateMemoryBlocks(1 ~ 32) or free random live range (half and half), BLOCK_PLACEMENT_OP_COUNT operations
+		- memory tag which doesn't go through magazines, memory blocks are committed but never touched
+*/
+enum
+{
+	BLOCK_PLACEMENT_OP_COUNT = 200 * 1000,
+	BLOCK_PLACEMENT_MAX_LIVE_COUNT = 64,
+	BLOCK_PLACEMENT_MAX_BLOCK_COUNT = 32,
+};
+
+static void RunBlockPlacementCase(H1MemoryArena::BlockPlacement InPlacement, H1MemoryBenchmark::BlockPlacementResult& OutResult)
+{
+	const H1MemoryArena::MemoryTag Tag = H1MemoryArena::MemoryTag_Assets;
+
+	// private memory arena, so the pages are only for this workload
+	H1MemoryArena* MemoryArena = new H1MemoryArena(H1MemoryArena::VirtualMemory);
+	MemoryArena->SetBlockPlacement(InPlacement);
+
+	byte* LiveAddresses[BLOCK_PLACEMENT_MAX_LIVE_COUNT];
+	int32 LiveCount = 0;
+
+	H1BenchmarkRandom Random(0xB10C);
+
+	uint64 StartTime = appGetTimeNanoseconds();
+	for (int32 Count = 0; Count < BLOCK_PLACEMENT_OP_COUNT; ++Count)
+	{
+		if (LiveCount == 0 || (LiveCount < BLOCK_PLACEMENT_MAX_LIVE_COUNT && Random.Next(2) == 0))
+		{
+			int32 BlockCount = 1 + Random.Next(BLOCK_PLACEMENT_MAX_BLOCK_COUNT);
+			LiveAddresses[LiveCount++] = MemoryArena->AllocateMemoryBlocks(BlockCount, Tag).BaseAddress;
+		}
+		else
+		{
+			int32 Index = Random.Next(LiveCount);
+			MemoryArena->DeallocateByAddress(LiveAddresses[Index]);
+			LiveAddresses[Index] = LiveAddresses[--LiveCount];
+		}
+	}
+
+	while (LiveCount > 0)
+	{
+		MemoryArena->DeallocateByAddress(LiveAddresses[--LiveCount]);
+	}
+	uint64 EndTime = appGetTimeNanoseconds();
+
+	OutResult.Placement = InPlacement;
+	OutResult.ElapsedNanoseconds = (int64)(EndTime - StartTime);
+	OutResult.PageCount = MemoryArena->GetTagPageCount(Tag);
+
+	delete MemoryArena;
+}
+
+void H1MemoryBenchmark::RunBlockPlacement(BlockPlacementResult (&OutResults)[BLOCK_PLACEMENT_CASE_COUNT])
+{
+	RunBlockPlacementCase(H1MemoryArena::BlockPlacement_BestFit, OutResults[0]);
+	RunBlockPlacementCase(H1MemoryArena::BlockPlacement_FirstFit, OutResults[1]);
+
+	h1MemDebugf("memory block placement benchmark (%d operations, 1 ~ %d memory blocks)", BLOCK_PLACEMENT_OP_COUNT, BLOCK_PLACEMENT_MAX_BLOCK_COUNT);
+	for (int32 Index = 0; Index < BLOCK_PLACEMENT_CASE_COUNT; ++Index)
+	{
+		const BlockPlacementResult& Result = OutResults[Index];
+		h1MemDebugf("\t%s: %lld ms, %lld pages", (Result.Placement == H1MemoryArena::BlockPlacement_BestFit) ? "best-fit" : "first-fit", Result.ElapsedNanoseconds / 1000000, Result.PageCount);
+	}
+}
+
+/*
+	fan-out benchmark
+		- threads are created and wait for the start flag, so thread creation is not measured
+		- thread entry point has no parameter (appCreateThread), so the state is shared by global variable and each thread takes its index
+*/
+enum
+{
+	FAN_OUT_ITEM_SIZE = 48,
+};
+
+struct H1FanOutBenchmarkState
+{
+	H1MemoryBenchmark::FanOutMode Mode;
+	H1SharedLinearAllocator* SharedAllocator;
+	H1MemStack* MemStacks[H1MemoryBenchmark::FAN_OUT_MAX_THREAD_COUNT];
+
+	SGD::atomic<int32> NextThreadIndex;
+	SGD::atomic<int32> ReadyCount;
+	SGD::atomic<bool> bStart;
+};
+
+H1FanOutBenchmarkState GFanOutBenchmarkState;
+
+static void PushFanOutItems(int32 ThreadIndex, H1MemStack* MemStack)
+{
+	H1FanOutBenchmarkState& State = GFanOutBenchmarkState;
+	H1SharedLinearAllocator::ThreadChunk Chunk;
+
+	for (int32 Count = 0; Count < H1MemoryBenchmark::FAN_OUT_PUSH_COUNT; ++Count)
+	{
+		byte* Item = nullptr;
+		switch (State.Mode)
+		{
+		case H1MemoryBenchmark::FanOut_SharedThreadChunk: Item = State.SharedAllocator->Push(Chunk, FAN_OUT_ITEM_SIZE); break;
+		case H1MemoryBenchmark::FanOut_SharedCursor: Item = State.SharedAllocator->Push(FAN_OUT_ITEM_SIZE); break;
+		default: Item = MemStack->Push(FAN_OUT_ITEM_SIZE); break;
+		}
+
+		// write the result
+		int64* Values = (int64*)Item;
+		Values[0] = ThreadIndex;
+		Values[1] = Count;
+	}
+}
+
+DWORD WINAPI FanOutBenchmarkEntryPoint(LPVOID lpThreadParameter)
+{
+	H1FanOutBenchmarkState& State = GFanOutBenchmarkState;
+	int32 ThreadIndex = State.NextThreadIndex.fetch_add(1);
+
+	// wait until all threads are ready
+	State.ReadyCount.fetch_add(1);
+	while (!State.bStart.load())
+	{
+		SGD::Thread::appSleep(0);
+	}
+
+	if (State.Mode == H1MemoryBenchmark::FanOut_PerThreadStack)
+	{
+		// released by memory mark like per-frame usage (memory tags go to the spare list of the stack)
+		H1MemMark Mark(*State.MemStacks[ThreadIndex]);
+		PushFanOutItems(ThreadIndex, State.MemStacks[ThreadIndex]);
+	}
+	else
+	{
+		PushFanOutItems(ThreadIndex, nullptr);
+	}
+
+	return 0;
+}
+
+// memory of the mode is kept alive across the runs of the case, like steady-state frames
+static void CreateFanOutMemory(H1MemoryBenchmark::FanOutMode InMode, int32 ThreadCount)
+{
+	H1FanOutBenchmarkState& State = GFanOutBenchmarkState;
+	State.SharedAllocator = nullptr;
+
+	if (InMode == H1MemoryBenchmark::FanOut_PerThreadStack)
+	{
+		for (int32 Index = 0; Index < ThreadCount; ++Index)
+		{
+			State.MemStacks[Index] = new H1MemStack();
+		}
+	}
+	else
+	{
+		// enough for the worst padding of every push, and the last chunk of every thread
+		int64 BufferSize = (int64)ThreadCount * H1MemoryBenchmark::FAN_OUT_PUSH_COUNT * (FAN_OUT_ITEM_SIZE + H1SharedLinearAllocator::DEFAULT_ALIGNMENT)
+			+ (int64)ThreadCount * H1SharedLinearAllocator::DEFAULT_CHUNK_SIZE;
+		int32 MemoryBlockCount = (int32)((BufferSize + H1MemoryArena::MEMORY_BLOCK_SIZE - 1) / H1MemoryArena::MEMORY_BLOCK_SIZE);
+		State.SharedAllocator = new H1SharedLinearAllocator(MemoryBlockCount);
+	}
+}
+
+static void DestroyFanOutMemory(H1MemoryBenchmark::FanOutMode InMode, int32 ThreadCount)
+{
+	H1FanOutBenchmarkState& State = GFanOutBenchmarkState;
+
+	if (InMode == H1MemoryBenchmark::FanOut_PerThreadStack)
+	{
+		for (int32 Index = 0; Index < ThreadCount; ++Index)
+		{
+			delete State.MemStacks[Index];
+			State.MemStacks[Index] = nullptr;
+		}
+	}
+	else
+	{
+		delete State.SharedAllocator;
+		State.SharedAllocator = nullptr;
+	}
+}
+
+static void RunFanOutCase(H1MemoryBenchmark::FanOutMode InMode, int32 ThreadCount, H1MemoryBenchmark::FanOutResult& OutResult)
+{
+	H1FanOutBenchmarkState& State = GFanOutBenchmarkState;
+	State.Mode = InMode;
+	State.NextThreadIndex.store(0);
+	State.ReadyCount.store(0);
+	State.bStart.store(false);
+
+	// the pushes of this run are released by resetting to the mark (memory stacks are released by memory mark in each thread)
+	uint64 SharedMark = (State.SharedAllocator != nullptr) ? State.SharedAllocator->GetMark() : 0;
+
+	SGD::Thread::CreateThreadOutput Threads[H1MemoryBenchmark::FAN_OUT_MAX_THREAD_COUNT];
+	H1ThreadHandleType ThreadHandles[H1MemoryBenchmark::FAN_OUT_MAX_THREAD_COUNT];
+
+	SGD::Thread::CreateThreadInput Input;
+	Input.StackSize = 64 * 1024;
+
+	int32 CreatedThreadCount = 0;
+	for (int32 Index = 0; Index < ThreadCount; ++Index)
+	{
+		if (SGD::Thread::appCreateThread(Threads[Index], Input, FanOutBenchmarkEntryPoint))
+		{
+			ThreadHandles[CreatedThreadCount++] = Threads[Index].ThreadHandle;
+		}
+	}
+	h1MemCheckf(CreatedThreadCount == ThreadCount, "failed to create fan-out benchmark threads (%d/%d)", CreatedThreadCount, ThreadCount);
+
+	while (State.ReadyCount.load() != ThreadCount)
+	{
+		SGD::Thread::appSleep(0);
+	}
+
+	uint64 StartTime = appGetTimeNanoseconds();
+	State.bStart.store(true);
+
+	SGD::Thread::JointThreadInput JoinInput;
+	JoinInput.NumThreads = ThreadCount;
+	JoinInput.ThreadArray = ThreadHandles;
+	SGD::Thread::appJoinThreads(JoinInput);
+	uint64 EndTime = appGetTimeNanoseconds();
+
+	OutResult.Mode = InMode;
+	OutResult.ThreadCount = ThreadCount;
+	OutResult.ElapsedNanoseconds = (int64)(EndTime - StartTime);
+
+	if (State.SharedAllocator != nullptr)
+	{
+		h1MemCheck(State.SharedAllocator->GetUsedSize() < State.SharedAllocator->GetCapacity(), "shared linear allocator is exhausted, please check the buffer size!");
+		State.SharedAllocator->ResetToMark(SharedMark);
+	}
+}
+
+void H1MemoryBenchmark::RunFanOut(int32 ThreadCount, FanOutResult (&OutResults)[FanOut_Count])
+{
+	h1MemCheck(ThreadCount > 0 && ThreadCount <= FAN_OUT_MAX_THREAD_COUNT, "invalid thread count for fan-out benchmark!");
+
+	static const char* ModeNames[FanOut_Count] = { "shared (thread chunk)", "shared (cursor)", "per-thread stack" };
+
+	h1MemDebugf("fan-out benchmark (%d threads, %d pushes of %d bytes each)", ThreadCount, FAN_OUT_PUSH_COUNT, FAN_OUT_ITEM_SIZE);
+	for (int32 Mode = 0; Mode < FanOut_Count; ++Mode)
+	{
+		// the first run faults in fresh memory blocks, the second run reuses them like steady-state frames (the buffer is reset to the mark, memory tags are in the spare list of each stack)
+		CreateFanOutMemory((FanOutMode)Mode, ThreadCount);
+		RunFanOutCase((FanOutMode)Mode, ThreadCount, OutResults[Mode]);
+		RunFanOutCase((FanOutMode)Mode, ThreadCount, OutResults[Mode]);
+		DestroyFanOutMemory((FanOutMode)Mode, ThreadCount);
+
+		h1MemDebugf("\t%s: %lld ms", ModeNames[Mode], OutResults[Mode].ElapsedNanoseconds / 1000000);
+	}
+}
+
+void H1MemoryBenchmark::RunAll()
+{
+	PageSizeResult PageSizeResults[PAGE_SIZE_CASE_COUNT];
+	RunPageSize(PageSizeResults);
+
+	BlockPlacementResult BlockPlacementResults[BLOCK_PLACEMENT_CASE_COUNT];
+	RunBlockPlacement(BlockPlacementResults);
+
+	FanOutResult FanOutResults[FanOut_Count];
+	RunFanOut(FAN_OUT_DEFAULT_THREAD_COUNT, FanOutResults);
+}
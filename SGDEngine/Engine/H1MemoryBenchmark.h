@@ -0,0 +1,91 @@
+#pragma once
+
+#include "H1MemoryArena.h"
+
+namespace SGD
+{
+namespace Memory
+{
+	/*
+		H1MemoryBenchmark
+			- fixed (deterministic) workloads for allocator tuning, so the numbers behind the tuning decisions can be reproduced
+			- it is not run by the engine loop (see SGD_RUN_MEMORY_BENCHMARK), each run returns its results and logs them (h1MemDebugf)
+			- elapsed time depends on the machine, compare the cases of one run rather than absolute numbers
+	*/
+	class H1MemoryBenchmark
+	{
+	public:
+		// block allocator page size
+		//	- H1BlockAllocPolicy (one pool for each size class) over H1DefaultAllocPagePolicy with 4KB, 64KB and 1MB pages
+		//	- fixed object-size mix (16B ~ 1KB): fill the live set, churn (free and allocate random objects), then free all
+		enum
+		{
+			PAGE_SIZE_CASE_COUNT = 3,
+		};
+
+		struct PageSizeResult
+		{
+			int32 PageSize;
+			int64 ElapsedNanoseconds;
+			// chunks (memory blocks) taken from memory arena by the page policies
+			//	- it is not process resident size: the memory arena is shared, so its memory blocks can be resident before the benchmark
+			int64 PeakChunkSize;
+			// pages carved by the block allocators (what is really touched)
+			int64 PeakPageSize;
+		};
+
+		static void RunPageSize(PageSizeResult (&OutResults)[PAGE_SIZE_CASE_COUNT]);
+
+		// memory block placement in the page (H1MemoryArena::SetBlockPlacement), best-fit and first-fit
+		//	- mixed 1..32 memory block workload on private memory arena: allocate or free random ranges, up to 64 ranges alive
+		enum
+		{
+			BLOCK_PLACEMENT_CASE_COUNT = 2,
+		};
+
+		struct BlockPlacementResult
+		{
+			H1MemoryArena::BlockPlacement Placement;
+			int64 ElapsedNanoseconds;
+			// memory pages are never released during the workload, so it is the peak
+			int64 PageCount;
+		};
+
+		static void RunBlockPlacement(BlockPlacementResult (&OutResults)[BLOCK_PLACEMENT_CASE_COUNT]);
+
+		// parallel fan-out into transient memory, H1SharedLinearAllocator against per-thread H1MemStack
+		//	- each thread pushes FAN_OUT_PUSH_COUNT items (48B) and writes them, the time is measured from all threads released to all joined
+		//	- memory is taken before the time is measured (shared buffer) or while measured (memory tags of stacks), as each is used in real
+		//	- each case runs twice on the same memory stacks (or shared buffer) and the second run is reported (memory blocks are already faulted in, like steady-state frames)
+		enum FanOutMode
+		{
+			// thread chunk (one atomic operation per chunk refill)
+			FanOut_SharedThreadChunk = 0,
+			// shared cursor (one atomic operation per push)
+			FanOut_SharedCursor,
+			// H1MemStack for each thread (no synchronization, results are separate)
+			FanOut_PerThreadStack,
+			FanOut_Count,
+		};
+
+		enum
+		{
+			FAN_OUT_DEFAULT_THREAD_COUNT = 8,
+			FAN_OUT_MAX_THREAD_COUNT = 64,
+			FAN_OUT_PUSH_COUNT = 200 * 1000,
+		};
+
+		struct FanOutResult
+		{
+			FanOutMode Mode;
+			int32 ThreadCount;
+			int64 ElapsedNanoseconds;
+		};
+
+		static void RunFanOut(int32 ThreadCount, FanOutResult (&OutResults)[FanOut_Count]);
+
+		// run all benchmarks above (results are only logged)
+		static void RunAll();
+	};
+}
+}
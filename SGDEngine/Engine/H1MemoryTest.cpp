@@ -0,0 +1,131 @@
+#include "H1EnginePrivate.h"
+#include "H1MemoryTest.h"
+
+// memory logger
+#include "H1MemoryLogger.h"
+
+#include "H1MemStackArray.h"
+#include "H1SharedLinearAllocator.h"
+
+using namespace SGD::Memory;
+
+void H1MemoryTest::RunMemStackArrayUnderMark()
+{
+	// without memory mark: the array is the first allocation of the first memory tag
+	{
+		H1MemStack MemStack;
+		{
+			H1MemStackArray<int32> Array(MemStack);
+			Array.Add(1);
+		}
+
+		// the first memory tag is kept, so next push starts from the beginning of it
+		byte* Address = MemStack.Push(16);
+		MemStack.Pop(Address);
+		h1MemCheck(MemStack.GetSpareTagCount() == 0, "the first memory tag should not be released");
+	}
+
+	// under memory mark taken at the beginning of the first memory tag
+	{
+		H1MemStack MemStack;
+		{
+			H1MemMark Mark(MemStack);
+			{
+				H1MemStackArray<int32> Array(MemStack);
+				Array.Add(1);
+			}
+
+			// the marked memory tag is kept until the memory mark is popped
+			h1MemCheck(MemStack.GetSpareTagCount() == 0, "the marked memory tag should not be released by pop");
+		}
+		h1MemCheck(MemStack.GetSpareTagCount() == 0, "the marked memory tag should not be released by memory mark");
+	}
+}
+
+// non-trivially destructible object counting its destructions
+struct H1MemoryTestObject
+{
+	H1MemoryTestObject() : Value(0) {}
+	~H1MemoryTestObject() { DestructCount++; }
+
+	int64 Value;
+
+	static int32 DestructCount;
+};
+
+int32 H1MemoryTestObject::DestructCount = 0;
+
+void H1MemoryTest::RunMemStackPopTypedObject()
+{
+	H1MemStack MemStack;
+	H1MemoryTestObject::DestructCount = 0;
+
+	// something below, so the pop doesn't reach the start of memory tag
+	MemStack.Push(16);
+
+	// the object and its destructor record are released by one pop
+	H1MemoryTestObject* Object = MemStack.New<H1MemoryTestObject>();
+	MemStack.Pop(Object);
+	h1MemCheck(H1MemoryTestObject::DestructCount == 1, "the destructor should be run by pop");
+
+	H1MemoryTestObject* Objects = MemStack.NewArray<H1MemoryTestObject>(4);
+	MemStack.Pop(Objects);
+	h1MemCheck(H1MemoryTestObject::DestructCount == 5, "the destructors should be run by pop");
+
+	// the records are released, next push is validated against the right record
+	byte* Address = MemStack.Push(32);
+	MemStack.Pop(Address);
+}
+
+void H1MemoryTest::RunMemStackUsedSize()
+{
+#if !FINAL_RELEASE
+	H1MemStack MemStack;
+
+	// odd size, so the next aligned push has padding
+	MemStack.Push(1);
+	uint64 UsedSize = MemStack.GetUsedSize();
+
+	for (int32 Index = 0; Index < 1000; ++Index)
+	{
+		byte* Address = MemStack.Push(24, 64);
+		MemStack.Pop(Address);
+	}
+	h1MemCheck(MemStack.GetUsedSize() == UsedSize, "pop should return the alignment padding of the allocation");
+#endif
+}
+
+void H1MemoryTest::RunSharedLinearAllocatorReset()
+{
+	H1SharedLinearAllocator Allocator(1);
+	H1SharedLinearAllocator::ThreadChunk Chunk;
+
+	// the chunk is reserved below the mark
+	byte* First = Allocator.Push(Chunk, 16);
+	uint64 Mark = Allocator.GetMark();
+
+	// nested scope reset above the chunk keeps it
+	Allocator.Push(1024);
+	Allocator.ResetToMark(Mark);
+	byte* Second = Allocator.Push(Chunk, 16);
+	h1MemCheck(Second == First + 16, "thread chunk below the mark should be kept by the reset");
+
+	// exhausted (the cursor is clamped to the capacity)
+	h1MemCheck(Allocator.Push(Allocator.GetCapacity()) == nullptr, "the push over the capacity should fail");
+	h1MemCheck(Allocator.Push(Allocator.GetCapacity()) == nullptr, "the push over the capacity should fail");
+
+	// frame reset discards the chunk
+	Allocator.Reset();
+	byte* Third = Allocator.Push(Chunk, 16);
+	h1MemCheck(Third == Allocator.GetBaseAddress(), "thread chunk should be refilled after the reset");
+}
+
+void H1MemoryTest::RunAll()
+{
+	RunMemStackArrayUnderMark();
+	RunMemStackPopTypedObject();
+	RunMemStackUsedSize();
+	RunSharedLinearAllocatorReset();
+
+	h1MemDebug("memory tests passed");
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+namespace SGD
+{
+namespace Memory
+{
+	/*
+		H1MemoryTest
+			- regression checks for memory allocators (each case fails by h1MemCheck, so it is only meaningful in non-final build)
+			- it is not run by the engine loop (see SGD_RUN_MEMORY_TEST)
+	*/
+	class H1MemoryTest
+	{
+	public:
+		// H1MemStackArray pushed under memory mark on fresh memory stack, destroyed before the memory mark
+		static void RunMemStackArrayUnderMark();
+		// Pop by pointer of typed allocation (New/NewArray) which registers its destructor
+		static void RunMemStackPopTypedObject();
+		// used size of memory stack is restored by pop (including alignment padding)
+		static void RunMemStackUsedSize();
+		// H1SharedLinearAllocator reset: nested scope reset keeps thread chunks, frame reset discards them
+		static void RunSharedLinearAllocatorReset();
+
+		// run all tests above
+		static void RunAll();
+	};
+}
+}
@@ -53,6 +53,9 @@ namespace Thread
 	// set thread affinity
 	void appSetThreadAffinity(H1ThreadHandleType ThreadHandle, uint32 CPUCoreId);
 
+	// set thread priority lower than normal threads (background work which shouldn't steal time from main thread)
+	void appSetThreadLowPriority(H1ThreadHandleType ThreadHandle);
+
 	// sleep
 	void appSleep(int32 MilliSeconds = 0);
 
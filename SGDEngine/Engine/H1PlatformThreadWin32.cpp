@@ -49,6 +49,11 @@ void SGD::Thread::appSetThreadAffinity(H1ThreadHandleType ThreadHandle, uint32 C
 	SetThreadAffinityMask(ThreadHandle, Mask);
 }
 
+void SGD::Thread::appSetThreadLowPriority(H1ThreadHandleType ThreadHandle)
+{
+	SetThreadPriority(ThreadHandle, THREAD_PRIORITY_LOWEST);
+}
+
 void SGD::Thread::appSleep(int32 MilliSeconds)
 {
 	Sleep(MilliSeconds);
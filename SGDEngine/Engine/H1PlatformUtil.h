@@ -16,6 +16,8 @@ namespace Util
 		bool appBitTestAndSet64(uint64 Offset, uint64& Mask);
 		bool appBitTest(uint32 Offset, uint32 Mask);
 		bool appBitTest64(uint64 Offset, uint64 Mask);
+		// number of set bits (population count)
+		uint32 appCountBits64(uint64 Mask);
 
 		// output debug string
 		void appOutputDebugString(const char* String);
@@ -23,6 +25,57 @@ namespace Util
 		// memory operation
 		void appMemzero(byte* Address, int64 Size);
 		void appMemcpy(const byte* SrcAddress, byte* DestAddress, int64 Size);
+		// aligned heap allocation
+		byte* appAlignedMalloc(int64 Size, int64 Alignment);
+		void appAlignedFree(byte* Address);
+
+		// virtual memory operation
+		//	- reserve only takes the address range (PROT_NONE/PAGE_NOACCESS), no physical memory is backed
+		//	- commit makes the reserved range accessible, OS gives us zero-filled memory on first touch
+		byte* appReserveVirtualMemory(int64 Size);
+		bool appCommitVirtualMemory(byte* Address, int64 Size);
+		bool appDecommitVirtualMemory(byte* Address, int64 Size);
+		void appReleaseVirtualMemory(byte* Address, int64 Size);
+		// reserve the address range which is aligned to Alignment (power of two, bigger than allocation granularity)
+		byte* appReserveAlignedVirtualMemory(int64 Size, int64 Alignment);
+		// OS page size (commit granularity)
+		int64 appGetVirtualMemoryPageSize();
+		// resize committed range by remapping its physical pages (mremap), the range could be moved to other address
+		//	- it returns nullptr when it is not supported (or failed), the caller should copy the range by itself
+		byte* appRemapVirtualMemory(byte* Address, int64 OldSize, int64 NewSize);
+		// fault in physical pages of committed range ahead (content is preserved)
+		//	- populate the page tables in one call (MADV_POPULATE_WRITE), or touch every OS page as fallback
+		void appPrefaultVirtualMemory(byte* Address, int64 Size);
+
+		// huge page operation
+		//	- explicit huge page commit (MAP_HUGETLB), it fails when the OS has no reserved huge page
+		//	- advise transparent huge page (MADV_HUGEPAGE) on already committed range
+		bool appCommitVirtualMemoryHugePage(byte* Address, int64 Size);
+		bool appAdviseHugePage(byte* Address, int64 Size);
+		int64 appGetHugePageSize();
+
+		// NUMA
+		//	- node count is 1 on single node machine (or when topology is not available)
+		int32 appGetNumaNodeCount();
+		int32 appGetCurrentNumaNode();
+		// prefer the NUMA node for the range (before it is touched), it returns false when it is not supported
+		bool appBindVirtualMemoryToNumaNode(byte* Address, int64 Size, int32 NumaNode);
+
+		// memory mapped file
+		//	- open (or create) the file and make it at least Size bytes (sparse), it returns the mapping handle (-1 when it is failed)
+		//	- view is shared with the file, DesiredAddress maps the view exactly at the address (nullptr when the address is taken)
+		int64 appOpenMappedFile(const char* FilePath, int64 Size);
+		void appCloseMappedFile(int64 MappedFile);
+		byte* appMapFileView(int64 MappedFile, int64 Offset, int64 Size, byte* DesiredAddress);
+		void appUnmapFileView(byte* Address, int64 Size);
+		// write dirty pages of the view back to the file (synchronously)
+		bool appFlushFileView(byte* Address, int64 Size);
+
+		// time
+		//	- monotonic time in milliseconds (coarse, cheap enough to call on every deallocation)
+		uint64 appGetTimeMilliseconds();
+		//	- high resolution monotonic time in nanoseconds (for measuring short duration like lock contention)
+		uint64 appGetTimeNanoseconds();
 
 		// string
 		uint32 appStrLen(const char* Str);
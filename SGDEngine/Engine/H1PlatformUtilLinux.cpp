@@ -0,0 +1,386 @@
+#include "H1EnginePrivate.h"
+
+// only for linux platform
+#if SGD_LINUX_PLATFORM
+#include "H1PlatformUtil.h"
+
+// include headers for linux specific
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+namespace SGD {
+namespace Platform {
+namespace Util
+{
+bool appBitScanReverse(uint32& Offset, uint32 Mask)
+{
+	if (Mask == 0)
+		return false;
+
+	Offset = 31 - (uint32)__builtin_clz(Mask);
+	return true;
+}
+
+bool appBitScanReverse64(uint64& Offset, uint64 Mask)
+{
+	if (Mask == 0)
+		return false;
+
+	Offset = 63 - (uint64)__builtin_clzll(Mask);
+	return true;
+}
+
+bool appBitScanForward(uint32& Offset, uint32 Mask)
+{
+	if (Mask == 0)
+		return false;
+
+	Offset = (uint32)__builtin_ctz(Mask);
+	return true;
+}
+
+bool appBitScanForward64(uint64& Offset, uint64 Mask)
+{
+	if (Mask == 0)
+		return false;
+
+	Offset = (uint64)__builtin_ctzll(Mask);
+	return true;
+}
+
+bool appBitTestAndReset(uint32 Offset, uint32& Mask)
+{
+	bool Result = (Mask & (1u << Offset)) != 0;
+	Mask &= ~(1u << Offset);
+	return Result;
+}
+
+bool appBitTestAndReset64(uint64 Offset, uint64& Mask)
+{
+	bool Result = (Mask & (1ull << Offset)) != 0;
+	Mask &= ~(1ull << Offset);
+	return Result;
+}
+
+bool appBitTestAndSet(uint32 Offset, uint32& Mask)
+{
+	bool Result = (Mask & (1u << Offset)) != 0;
+	Mask |= (1u << Offset);
+	return Result;
+}
+
+bool appBitTestAndSet64(uint64 Offset, uint64& Mask)
+{
+	bool Result = (Mask & (1ull << Offset)) != 0;
+	Mask |= (1ull << Offset);
+	return Result;
+}
+
+bool appBitTest(uint32 Offset, uint32 Mask)
+{
+	return (Mask & (1u << Offset)) != 0;
+}
+
+bool appBitTest64(uint64 Offset, uint64 Mask)
+{
+	return (Mask & (1ull << Offset)) != 0;
+}
+
+uint32 appCountBits64(uint64 Mask)
+{
+	return (uint32)__builtin_popcountll(Mask);
+}
+
+void appOutputDebugString(const char* String)
+{
+	fputs(String, stderr);
+}
+
+void appMemzero(byte* Address, int64 Size)
+{
+	memset(Address, 0, Size);
+}
+
+void appMemcpy(const byte* SrcAddress, byte* DestAddress, int64 Size)
+{
+	memcpy(DestAddress, SrcAddress, Size);
+}
+
+byte* appAlignedMalloc(int64 Size, int64 Alignment)
+{
+	void* Address = nullptr;
+	if (posix_memalign(&Address, (size_t)Alignment, (size_t)Size) != 0)
+	{
+		return nullptr;
+	}
+
+	return (byte*)Address;
+}
+
+void appAlignedFree(byte* Address)
+{
+	free(Address);
+}
+
+byte* appReserveVirtualMemory(int64 Size)
+{
+	// MAP_NORESERVE: do not account swap space for the reserved range
+	void* Address = mmap(nullptr, (size_t)Size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return (Address == MAP_FAILED) ? nullptr : (byte*)Address;
+}
+
+bool appCommitVirtualMemory(byte* Address, int64 Size)
+{
+	return mprotect(Address, (size_t)Size, PROT_READ | PROT_WRITE) == 0;
+}
+
+bool appDecommitVirtualMemory(byte* Address, int64 Size)
+{
+	// give physical pages back to the OS first, and then make the range inaccessible again
+	if (madvise(Address, (size_t)Size, MADV_DONTNEED) != 0)
+		return false;
+
+	return mprotect(Address, (size_t)Size, PROT_NONE) == 0;
+}
+
+void appReleaseVirtualMemory(byte* Address, int64 Size)
+{
+	munmap(Address, (size_t)Size);
+}
+
+byte* appReserveAlignedVirtualMemory(int64 Size, int64 Alignment)
+{
+	// over-reserve and trim unaligned head and tail
+	byte* Address = appReserveVirtualMemory(Size + Alignment);
+	if (Address == nullptr)
+	{
+		return nullptr;
+	}
+
+	byte* AlignedAddress = Align(Address, Alignment);
+	int64 HeadSize = AlignedAddress - Address;
+	int64 TailSize = Alignment - HeadSize;
+
+	if (HeadSize > 0)
+	{
+		munmap(Address, (size_t)HeadSize);
+	}
+
+	if (TailSize > 0)
+	{
+		munmap(AlignedAddress + Size, (size_t)TailSize);
+	}
+
+	return AlignedAddress;
+}
+
+int64 appGetVirtualMemoryPageSize()
+{
+	return (int64)sysconf(_SC_PAGESIZE);
+}
+
+byte* appRemapVirtualMemory(byte* Address, int64 OldSize, int64 NewSize)
+{
+	// page table entries are moved, no data is copied
+	void* NewAddress = mremap(Address, (size_t)OldSize, (size_t)NewSize, MREMAP_MAYMOVE);
+	return (NewAddress == MAP_FAILED) ? nullptr : (byte*)NewAddress;
+}
+
+void appPrefaultVirtualMemory(byte* Address, int64 Size)
+{
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+	// linux 5.14+ populates writable page tables without touching
+	if (madvise(Address, (size_t)Size, MADV_POPULATE_WRITE) == 0)
+	{
+		return;
+	}
+
+	// fallback to touch loop (write the value back, so the content is preserved)
+	int64 OSPageSize = appGetVirtualMemoryPageSize();
+	for (int64 Offset = 0; Offset < Size; Offset += OSPageSize)
+	{
+		volatile byte* TouchAddress = Address + Offset;
+		*TouchAddress = *TouchAddress;
+	}
+}
+
+bool appCommitVirtualMemoryHugePage(byte* Address, int64 Size)
+{
+	// replace reserved range with huge page mapping in place
+	void* Result = mmap(Address, (size_t)Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB, -1, 0);
+	if (Result == MAP_FAILED)
+	{
+		// failed MAP_FIXED could discard the previous mapping, so restore the reservation
+		mmap(Address, (size_t)Size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+		return false;
+	}
+
+	return true;
+}
+
+bool appAdviseHugePage(byte* Address, int64 Size)
+{
+	return madvise(Address, (size_t)Size, MADV_HUGEPAGE) == 0;
+}
+
+int64 appGetHugePageSize()
+{
+	// x86-64 default huge page size
+	return 2 * 1024 * 1024;
+}
+
+int32 appGetNumaNodeCount()
+{
+	// online nodes are listed as ranges like "0", "0-1" or "0,2-3"
+	FILE* File = fopen("/sys/devices/system/node/online", "r");
+	if (File == nullptr)
+	{
+		return 1;
+	}
+
+	char Buffer[256] = { 0 };
+	bool bRead = fgets(Buffer, sizeof(Buffer), File) != nullptr;
+	fclose(File);
+
+	if (!bRead)
+	{
+		return 1;
+	}
+
+	// the highest node number is the last number in the list
+	int32 HighestNodeNumber = 0;
+	int32 CurrNumber = -1;
+	for (char* Curr = Buffer; *Curr != 0; ++Curr)
+	{
+		if (*Curr >= '0' && *Curr <= '9')
+		{
+			CurrNumber = ((CurrNumber < 0) ? 0 : CurrNumber * 10) + (*Curr - '0');
+		}
+		else
+		{
+			HighestNodeNumber = (CurrNumber > HighestNodeNumber) ? CurrNumber : HighestNodeNumber;
+			CurrNumber = -1;
+		}
+	}
+	HighestNodeNumber = (CurrNumber > HighestNodeNumber) ? CurrNumber : HighestNodeNumber;
+
+	return HighestNodeNumber + 1;
+}
+
+int32 appGetCurrentNumaNode()
+{
+	unsigned int Cpu = 0;
+	unsigned int Node = 0;
+	if (syscall(SYS_getcpu, &Cpu, &Node, nullptr) != 0)
+	{
+		return 0;
+	}
+
+	return (int32)Node;
+}
+
+bool appBindVirtualMemoryToNumaNode(byte* Address, int64 Size, int32 NumaNode)
+{
+	// mbind directly (not to depend on libnuma), MPOL_PREFERRED falls back to other nodes when the node is out of memory
+	unsigned long NodeMask = 1ul << NumaNode;
+	return syscall(SYS_mbind, Address, (unsigned long)Size, MPOL_PREFERRED, &NodeMask, sizeof(NodeMask) * 8 + 1, 0) == 0;
+}
+
+int64 appOpenMappedFile(const char* FilePath, int64 Size)
+{
+	int FileDescriptor = open(FilePath, O_RDWR | O_CREAT, 0644);
+	if (FileDescriptor == -1)
+	{
+		return -1;
+	}
+
+	// extend the file without writing (sparse file), existing file is never truncated
+	struct stat FileStat;
+	if (fstat(FileDescriptor, &FileStat) != 0 || (FileStat.st_size < Size && ftruncate(FileDescriptor, (off_t)Size) != 0))
+	{
+		close(FileDescriptor);
+		return -1;
+	}
+
+	return (int64)FileDescriptor;
+}
+
+void appCloseMappedFile(int64 MappedFile)
+{
+	close((int)MappedFile);
+}
+
+byte* appMapFileView(int64 MappedFile, int64 Offset, int64 Size, byte* DesiredAddress)
+{
+	// MAP_FIXED_NOREPLACE never replaces existing mapping (old kernels take it as a hint, so the address is checked)
+	int Flags = MAP_SHARED;
+#ifdef MAP_FIXED_NOREPLACE
+	if (DesiredAddress != nullptr)
+	{
+		Flags |= MAP_FIXED_NOREPLACE;
+	}
+#endif
+
+	void* Address = mmap(DesiredAddress, (size_t)Size, PROT_READ | PROT_WRITE, Flags, (int)MappedFile, (off_t)Offset);
+	if (Address == MAP_FAILED)
+	{
+		return nullptr;
+	}
+
+	if (DesiredAddress != nullptr && Address != DesiredAddress)
+	{
+		munmap(Address, (size_t)Size);
+		return nullptr;
+	}
+
+	return (byte*)Address;
+}
+
+void appUnmapFileView(byte* Address, int64 Size)
+{
+	munmap(Address, (size_t)Size);
+}
+
+bool appFlushFileView(byte* Address, int64 Size)
+{
+	return msync(Address, (size_t)Size, MS_SYNC) == 0;
+}
+
+uint64 appGetTimeMilliseconds()
+{
+	timespec Time;
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &Time);
+	return (uint64)Time.tv_sec * 1000 + (uint64)Time.tv_nsec / 1000000;
+}
+
+uint64 appGetTimeNanoseconds()
+{
+	timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return (uint64)Time.tv_sec * 1000000000ull + (uint64)Time.tv_nsec;
+}
+
+uint32 appStrLen(const char* Str)
+{
+	return (uint32)strlen(Str);
+}
+
+void appStrcpy(const char* Src, char* Dest)
+{
+	//strcpy(Dest, Src);
+}
+
+}
+}
+}
+#endif
@@ -6,6 +6,7 @@
 
 // include headers for windows specific
 #include <intrin.h>
+#include <winioctl.h>
 
 namespace SGD {
 namespace Platform {
@@ -61,6 +62,11 @@ bool appBitTest64(uint64 Offset, uint64 Mask)
 	return _bittest64((const long long*)&Mask, Offset);
 }
 
+uint32 appCountBits64(uint64 Mask)
+{
+	return (uint32)__popcnt64(Mask);
+}
+
 void appOutputDebugString(const char* String)
 {
 	OutputDebugString(String);
@@ -76,6 +82,204 @@ void appMemcpy(const byte* SrcAddress, byte* DestAddress, int64 Size)
 	memcpy(DestAddress, SrcAddress, Size);
 }
 
+byte* appAlignedMalloc(int64 Size, int64 Alignment)
+{
+	return (byte*)_aligned_malloc((size_t)Size, (size_t)Alignment);
+}
+
+void appAlignedFree(byte* Address)
+{
+	_aligned_free(Address);
+}
+
+byte* appReserveVirtualMemory(int64 Size)
+{
+	return (byte*)VirtualAlloc(nullptr, (SIZE_T)Size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+bool appCommitVirtualMemory(byte* Address, int64 Size)
+{
+	return VirtualAlloc(Address, (SIZE_T)Size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+bool appDecommitVirtualMemory(byte* Address, int64 Size)
+{
+	return VirtualFree(Address, (SIZE_T)Size, MEM_DECOMMIT) != 0;
+}
+
+void appReleaseVirtualMemory(byte* Address, int64 Size)
+{
+	// MEM_RELEASE requires zero size (it releases the whole reservation)
+	VirtualFree(Address, 0, MEM_RELEASE);
+}
+
+byte* appReserveAlignedVirtualMemory(int64 Size, int64 Alignment)
+{
+	// windows can't release the part of reservation, so find the aligned range and re-reserve it
+	//	- other thread can take the range in between, so retry few times
+	for (int32 TryCount = 0; TryCount < 8; ++TryCount)
+	{
+		byte* Address = appReserveVirtualMemory(Size + Alignment);
+		if (Address == nullptr)
+		{
+			return nullptr;
+		}
+
+		byte* AlignedAddress = Align(Address, Alignment);
+		VirtualFree(Address, 0, MEM_RELEASE);
+
+		Address = (byte*)VirtualAlloc(AlignedAddress, (SIZE_T)Size, MEM_RESERVE, PAGE_NOACCESS);
+		if (Address == AlignedAddress)
+		{
+			return Address;
+		}
+	}
+
+	return nullptr;
+}
+
+int64 appGetVirtualMemoryPageSize()
+{
+	SYSTEM_INFO SystemInfo;
+	GetSystemInfo(&SystemInfo);
+	return (int64)SystemInfo.dwPageSize;
+}
+
+byte* appRemapVirtualMemory(byte* Address, int64 OldSize, int64 NewSize)
+{
+	// windows has no equivalent of mremap
+	return nullptr;
+}
+
+void appPrefaultVirtualMemory(byte* Address, int64 Size)
+{
+	// PrefetchVirtualMemory only brings pages which are already backed (e.g. paged out), fresh committed pages should be touched
+	int64 OSPageSize = appGetVirtualMemoryPageSize();
+	for (int64 Offset = 0; Offset < Size; Offset += OSPageSize)
+	{
+		volatile byte* TouchAddress = Address + Offset;
+		*TouchAddress = *TouchAddress;
+	}
+}
+
+bool appCommitVirtualMemoryHugePage(byte* Address, int64 Size)
+{
+	// large page (MEM_LARGE_PAGES) should be reserved and committed at once, it can't be committed into existing reservation
+	return false;
+}
+
+bool appAdviseHugePage(byte* Address, int64 Size)
+{
+	// no transparent huge page in windows
+	return false;
+}
+
+int64 appGetHugePageSize()
+{
+	return (int64)GetLargePageMinimum();
+}
+
+int32 appGetNumaNodeCount()
+{
+	ULONG HighestNodeNumber = 0;
+	if (!GetNumaHighestNodeNumber(&HighestNodeNumber))
+	{
+		return 1;
+	}
+
+	return (int32)HighestNodeNumber + 1;
+}
+
+int32 appGetCurrentNumaNode()
+{
+	PROCESSOR_NUMBER ProcessorNumber;
+	GetCurrentProcessorNumberEx(&ProcessorNumber);
+
+	USHORT NodeNumber = 0;
+	if (!GetNumaProcessorNodeEx(&ProcessorNumber, &NodeNumber))
+	{
+		return 0;
+	}
+
+	return (int32)NodeNumber;
+}
+
+bool appBindVirtualMemoryToNumaNode(byte* Address, int64 Size, int32 NumaNode)
+{
+	// windows decides NUMA node when the range is committed (VirtualAllocExNuma), otherwise first-touch policy is applied
+	return false;
+}
+
+int64 appOpenMappedFile(const char* FilePath, int64 Size)
+{
+	HANDLE File = CreateFileA(FilePath, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		return -1;
+	}
+
+	// mark it as sparse, so the untouched range doesn't take the disk
+	DWORD BytesReturned = 0;
+	DeviceIoControl(File, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &BytesReturned, nullptr);
+
+	// file mapping extends the file up to its maximum size (existing file is never truncated)
+	LARGE_INTEGER FileSize;
+	GetFileSizeEx(File, &FileSize);
+	int64 MappingSize = (FileSize.QuadPart > Size) ? FileSize.QuadPart : Size;
+
+	HANDLE FileMapping = CreateFileMappingA(File, nullptr, PAGE_READWRITE, (DWORD)(MappingSize >> 32), (DWORD)(MappingSize & 0xFFFFFFFF), nullptr);
+
+	// the file mapping keeps the file open
+	CloseHandle(File);
+
+	return (FileMapping != nullptr) ? (int64)FileMapping : -1;
+}
+
+void appCloseMappedFile(int64 MappedFile)
+{
+	CloseHandle((HANDLE)MappedFile);
+}
+
+byte* appMapFileView(int64 MappedFile, int64 Offset, int64 Size, byte* DesiredAddress)
+{
+	// MapViewOfFileEx fails when the desired address is not available
+	return (byte*)MapViewOfFileEx((HANDLE)MappedFile, FILE_MAP_ALL_ACCESS, (DWORD)(Offset >> 32), (DWORD)(Offset & 0xFFFFFFFF), (SIZE_T)Size, DesiredAddress);
+}
+
+void appUnmapFileView(byte* Address, int64 Size)
+{
+	UnmapViewOfFile(Address);
+}
+
+bool appFlushFileView(byte* Address, int64 Size)
+{
+	// it writes dirty pages to the file (file metadata is updated lazily by OS)
+	return FlushViewOfFile(Address, (SIZE_T)Size) != 0;
+}
+
+uint64 appGetTimeMilliseconds()
+{
+	return (uint64)GetTickCount64();
+}
+
+uint64 appGetTimeNanoseconds()
+{
+	// performance counter frequency is fixed at system boot
+	static LARGE_INTEGER Frequency = { 0 };
+	if (Frequency.QuadPart == 0)
+	{
+		QueryPerformanceFrequency(&Frequency);
+	}
+
+	LARGE_INTEGER Counter;
+	QueryPerformanceCounter(&Counter);
+
+	// split to avoid overflow of Counter * 1e9
+	uint64 Seconds = (uint64)(Counter.QuadPart / Frequency.QuadPart);
+	uint64 Remainder = (uint64)(Counter.QuadPart % Frequency.QuadPart);
+	return Seconds * 1000000000ull + Remainder * 1000000000ull / (uint64)Frequency.QuadPart;
+}
+
 uint32 appStrLen(const char* Str)
 {
 	return (uint32)strlen(Str);
@@ -0,0 +1,113 @@
+#include "H1EnginePrivate.h"
+#include "H1SharedLinearAllocator.h"
+
+// memory logger
+#include "H1MemoryLogger.h"
+
+using namespace SGD::Memory;
+
+H1SharedLinearAllocator::H1SharedLinearAllocator(int32 MemoryBlockCount, uint64 InChunkSize, H1MemoryArena::MemoryTag InTag)
+	: MemoryBlocks(H1GlobalSingleton::MemoryArena()->AllocateMemoryBlocks(MemoryBlockCount, InTag))
+	, BaseAddress(nullptr)
+	, Capacity(0)
+	, ChunkSize(InChunkSize)
+	, Cursor(0)
+	, Epoch(1)
+	, ChunkEndOffset(0)
+{
+	h1MemCheck(MemoryBlocks.BaseAddress != nullptr, "failed to allocate memory blocks for shared linear allocator, please check!");
+
+	BaseAddress = MemoryBlocks.BaseAddress;
+	Capacity = (uint64)MemoryBlockCount * H1MemoryArena::MEMORY_BLOCK_SIZE;
+}
+
+H1SharedLinearAllocator::~H1SharedLinearAllocator()
+{
+	H1GlobalSingleton::MemoryArena()->DeallocateMemoryBlocks(MemoryBlocks);
+}
+
+byte* H1SharedLinearAllocator::Push(ThreadChunk& Chunk, uint64 Size, uint64 Alignment)
+{
+	// the chunk reserved before reset is not valid anymore
+	uint64 CurrEpoch = Epoch.load(std::memory_order_relaxed);
+	if (Chunk.Epoch == CurrEpoch)
+	{
+		byte* AllocatedAddress = SGD::Platform::Util::Align(Chunk.CurrAddress, Alignment);
+		if (AllocatedAddress + Size <= Chunk.EndAddress)
+		{
+			Chunk.CurrAddress = AllocatedAddress + Size;
+			return AllocatedAddress;
+		}
+	}
+
+	// bigger than the chunk, allocate directly (keep current chunk)
+	if (Size + Alignment > ChunkSize)
+	{
+		return Reserve(Size, Alignment);
+	}
+
+	// refill the chunk
+	byte* NewChunkAddress = Reserve(ChunkSize, DEFAULT_ALIGNMENT);
+	if (NewChunkAddress == nullptr)
+	{
+		return nullptr;
+	}
+
+	Chunk.EndAddress = NewChunkAddress + ChunkSize;
+	Chunk.Epoch = CurrEpoch;
+
+	// keep the end of the highest live chunk, so ResetToMark above it doesn't invalidate thread chunks
+	uint64 NewChunkEndOffset = (uint64)(Chunk.EndAddress - BaseAddress);
+	uint64 CurrChunkEndOffset = ChunkEndOffset.load(std::memory_order_relaxed);
+	while (CurrChunkEndOffset < NewChunkEndOffset && !ChunkEndOffset.compare_exchange_weak(CurrChunkEndOffset, NewChunkEndOffset, std::memory_order_relaxed))
+	{
+	}
+
+	byte* AllocatedAddress = SGD::Platform::Util::Align(NewChunkAddress, Alignment);
+	Chunk.CurrAddress = AllocatedAddress + Size;
+
+	return AllocatedAddress;
+}
+
+byte* H1SharedLinearAllocator::Push(uint64 Size, uint64 Alignment)
+{
+	return Reserve(Size, Alignment);
+}
+
+byte* H1SharedLinearAllocator::Reserve(uint64 Size, uint64 Alignment)
+{
+	// reserve with the worst padding, so only one atomic operation is needed
+	uint64 ReservedSize = Size + Alignment - 1;
+	uint64 Offset = Cursor.fetch_add(ReservedSize, std::memory_order_relaxed);
+	if (Offset + ReservedSize > Capacity)
+	{
+		// exhausted, clamp the cursor to the capacity (so failed reservations don't keep growing it)
+		uint64 CurrCursor = Offset + ReservedSize;
+		while (CurrCursor > Capacity && !Cursor.compare_exchange_weak(CurrCursor, Capacity, std::memory_order_relaxed))
+		{
+		}
+		return nullptr;
+	}
+
+	return SGD::Platform::Util::Align(BaseAddress + Offset, Alignment);
+}
+
+void H1SharedLinearAllocator::ResetToMark(uint64 Mark)
+{
+	h1MemCheck(Mark <= GetUsedSize(), "invalid mark for shared linear allocator, please check!");
+
+	Cursor.store(Mark, std::memory_order_relaxed);
+
+	// thread chunks are invalidated only when the mark is below a live chunk (nested scope reset above all chunks keeps them)
+	if (ChunkEndOffset.load(std::memory_order_relaxed) > Mark)
+	{
+		Epoch.fetch_add(1, std::memory_order_relaxed);
+		ChunkEndOffset.store(0, std::memory_order_relaxed);
+	}
+}
+
+uint64 H1SharedLinearAllocator::GetUsedSize() const
+{
+	uint64 CurrCursor = Cursor.load(std::memory_order_relaxed);
+	return (CurrCursor < Capacity) ? CurrCursor : Capacity;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "H1MemoryArena.h"
+#include "H1GlobalSingleton.h"
+
+namespace SGD
+{
+namespace Memory
+{
+	/*
+		H1SharedLinearAllocator
+			- linear allocator shared by multiple threads (e.g. parallel jobs writing results into one contiguous transient buffer)
+			- the buffer is contiguous memory blocks from memory arena, the cursor is advanced atomically
+			- each thread reserves sub-chunk (ChunkSize) with one atomic operation and bumps inside it without synchronization (ThreadChunk)
+			- Reset (frame or scope) is not thread-safe, call it when no thread is using the allocator; it invalidates thread chunks when the mark is below any of them
+	*/
+	class H1SharedLinearAllocator
+	{
+	public:
+		enum
+		{
+			DEFAULT_ALIGNMENT = 16,
+			DEFAULT_CHUNK_SIZE = 64 * 1024,
+		};
+
+		// sub-chunk reserved by one thread
+		//	- it is owned by each thread (or job), never shared
+		struct ThreadChunk
+		{
+			ThreadChunk()
+				: CurrAddress(nullptr), EndAddress(nullptr), Epoch(0)
+			{}
+
+			byte* CurrAddress;
+			byte* EndAddress;
+			// reset count of the allocator when the chunk was reserved
+			uint64 Epoch;
+		};
+
+		H1SharedLinearAllocator(int32 MemoryBlockCount, uint64 InChunkSize = DEFAULT_CHUNK_SIZE, H1MemoryArena::MemoryTag InTag = H1MemoryArena::MemoryTag_Default);
+		~H1SharedLinearAllocator();
+
+		// allocate from the thread chunk (thread-safe, the atomic operation only happens when the chunk is refilled)
+		//	- returns nullptr when the buffer is exhausted
+		byte* Push(ThreadChunk& Chunk, uint64 Size, uint64 Alignment = DEFAULT_ALIGNMENT);
+		// allocate from the shared cursor directly (thread-safe, one atomic operation per allocation)
+		byte* Push(uint64 Size, uint64 Alignment = DEFAULT_ALIGNMENT);
+
+		// release all allocations (frame reset)
+		void Reset() { ResetToMark(0); }
+
+		// scope reset: release allocations after the mark
+		uint64 GetMark() const { return GetUsedSize(); }
+		void ResetToMark(uint64 Mark);
+
+		byte* GetBaseAddress() const { return BaseAddress; }
+		uint64 GetCapacity() const { return Capacity; }
+		uint64 GetUsedSize() const;
+
+	protected:
+		// advance the shared cursor (the padding for Alignment is included)
+		byte* Reserve(uint64 Size, uint64 Alignment);
+
+		// contiguous memory blocks
+		H1MemoryBlockRange MemoryBlocks;
+		byte* BaseAddress;
+		uint64 Capacity;
+
+		uint64 ChunkSize;
+
+		// shared cursor (offset from BaseAddress), in its own cache line
+		alignas(64) SGD::atomic<uint64> Cursor;
+		// incremented by reset, thread chunks reserved before reset are discarded
+		SGD::atomic<uint64> Epoch;
+		// end offset of the highest thread chunk reserved in current epoch
+		SGD::atomic<uint64> ChunkEndOffset;
+	};
+}
+}
@@ -60,11 +60,17 @@ namespace Memory
 	};
 
 	// needed for std::allocator_traits
+	//	- default allocator is stateless (malloc/free), any instance can free the memory from another
+	template<typename T, typename U>
+	constexpr bool operator==(const H1StdAllocatorDefault<T>& a, const H1StdAllocatorDefault<U>& b) noexcept
+	{
+		return true;
+	}
+
 	template<typename T, typename U>
 	constexpr bool operator!=(const H1StdAllocatorDefault<T>& a, const H1StdAllocatorDefault<U>& b) noexcept
 	{
-		// just naive implementation
-		return &a != &b;
+		return false;
 	}
 }
 }
\ No newline at end of file
@@ -10,7 +10,7 @@ namespace Container
 	template <class Type, class Allocator = SGD::Memory::H1StdAllocatorDefault<Type> >
 	using H1Array = std::vector<Type, Allocator>;
 
-	template <class KeyType, class ValueType, class Allocator = SGD::Memory::H1StdAllocatorDefault<Type> >
-	using H1HashTable = std::unordered_map<KeyType, ValueType, Allocator>;
+	template <class KeyType, class ValueType, class Allocator = SGD::Memory::H1StdAllocatorDefault<std::pair<const KeyType, ValueType> > >
+	using H1HashTable = std::unordered_map<KeyType, ValueType, std::hash<KeyType>, std::equal_to<KeyType>, Allocator>;
 }
 }
\ No newline at end of file
@@ -26,26 +26,45 @@ namespace Thread
 			Data = InTaggedPointer.Data;
 		}
 
+		// restoring from raw data (the result of interlocked operation)
+		explicit H1TaggedPointer(int64 InData)
+		{
+			Data = InData;
+		}
+
+		H1TaggedPointer& operator=(const H1TaggedPointer& InTaggedPointer)
+		{
+			Data = InTaggedPointer.Data;
+			return *this;
+		}
+
+		// raw data for interlocked operation
+		explicit operator int64() const
+		{
+			return Data;
+		}
+
 		~H1TaggedPointer()
 		{}
 
 		NodeType* GetNode()
 		{
-			return (NodeType*)Layout.Pointer;
+			return (NodeType*)(Layout.Pointer << PointerShift);
 		}
 
 		// maintaining the tag count, change the node pointer
 		void SetNode(NodeType* InNode)
 		{
-			h1Check((int64)InNode < (1 << 45), "node pointer range should be within [0, (1 << 45)]!");
-			Layout.Pointer = (int64)InNode;
+			h1Check(((uint64)InNode & ((1ull << PointerShift) - 1)) == 0, "node pointer should be aligned to (1 << 3)!");
+			h1Check((uint64)InNode < (1ull << (PointerBitNum + PointerShift)), "node pointer range should be within [0, (1 << 47)]!");
+			Layout.Pointer = (uint64)InNode >> PointerShift;
 		}
 
 		// increment tag count
+		//	- tag count wraps around after (1 << 20) increments, ABA happens only when the head is changed exactly that many times between read and CAS
 		void IncrementTag()
 		{
 			Layout.Tag = Layout.Tag + 1;
-			h1Check(Layout.Tag < (1 << 21), "Tag should be smaller than (1 << 21)!");
 		}
 
 		bool operator==(const H1TaggedPointer& InTaggedPointer)
@@ -59,10 +78,19 @@ namespace Thread
 		}
 
 	protected:
+		enum
+		{
+			TagBitNum = 20,
+			PointerBitNum = 44,
+			// nodes are aligned to pointer size, so the lowest 3 bits of the address are not stored
+			//	- 44 bits keep x64 user-space address (47 bits, windows 8.1+ and linux) with 20 bits tag
+			PointerShift = 3,
+		};
+
 		struct TaggedPointer
 		{
-			int64 Tag : 20;
-			int64 Pointer : 44; // in windows system, maximum allowed bits for address is 44 bits
+			uint64 Tag : TagBitNum;
+			uint64 Pointer : PointerBitNum;
 		};
 
 		union
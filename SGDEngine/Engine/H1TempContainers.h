@@ -0,0 +1,89 @@
+#pragma once
+
+#include "H1WorkerThread.h"
+
+namespace SGD
+{
+namespace Memory
+{
+	// std allocator bound to H1MemStack
+	//	- stateful allocator, deallocate does nothing (the memory is reclaimed when H1MemMark is popped)
+	//	- temporary containers should not outlive the memory mark which was alive when they were created
+	template <typename T>
+	struct H1StdAllocatorMemStack
+	{
+		// used for std::allocator_traits
+		using value_type = T;
+
+		// the memory stack is not interchangeable, keep the bound memory stack on copy/move/swap of containers
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+		using is_always_equal = std::false_type;
+
+		explicit H1StdAllocatorMemStack(H1MemStack& InMemStack)
+			: MemStack(&InMemStack)
+		{
+
+		}
+
+		// bound to the memory stack of current thread
+		H1StdAllocatorMemStack()
+			: MemStack(&GWorkerThreadContext->GetMemStack())
+		{
+
+		}
+
+		// needed for std::allocator_traits
+		template <typename U>
+		H1StdAllocatorMemStack(const H1StdAllocatorMemStack<U>& InAllocator)
+			: MemStack(InAllocator.MemStack)
+		{
+
+		}
+
+		// needed for std::allocator_traits
+		T* allocate(size_t InSize)
+		{
+			return (T*)MemStack->Push(InSize * sizeof(T), alignof(T));
+		}
+
+		// needed for std::allocator_traits
+		void deallocate(T* InPointer, size_t)
+		{
+			// do nothing
+		}
+
+		template <typename U>
+		struct rebind
+		{
+			typedef H1StdAllocatorMemStack<U> other;
+		};
+
+		H1MemStack* MemStack;
+	};
+
+	// needed for std::allocator_traits
+	template<typename T, typename U>
+	bool operator==(const H1StdAllocatorMemStack<T>& a, const H1StdAllocatorMemStack<U>& b) noexcept
+	{
+		return a.MemStack == b.MemStack;
+	}
+
+	template<typename T, typename U>
+	bool operator!=(const H1StdAllocatorMemStack<T>& a, const H1StdAllocatorMemStack<U>& b) noexcept
+	{
+		return a.MemStack != b.MemStack;
+	}
+}
+
+namespace Container
+{
+	// temporary containers on the memory stack (zero heap traffic, e.g. scratch containers in jobs)
+	template <class Type>
+	using H1TempArray = std::vector<Type, SGD::Memory::H1StdAllocatorMemStack<Type> >;
+
+	template <class KeyType, class ValueType>
+	using H1TempHashTable = std::unordered_map<KeyType, ValueType, std::hash<KeyType>, std::equal_to<KeyType>, SGD::Memory::H1StdAllocatorMemStack<std::pair<const KeyType, ValueType> > >;
+}
+}
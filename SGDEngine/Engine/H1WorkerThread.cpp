@@ -24,6 +24,9 @@ uint32 H1WorkerThread_FiberImpl::Run(H1WorkerThread_Context* InContext)
 	// running thread
 	while (true)
 	{
+		// trim spare memory tags freed by the previous loop
+		Context->MemStack.Tick();
+
 		// marking user thread main loop
 		SGD::Memory::H1MemMark MainLoopMemMark(Context->MemStack);
 	}
@@ -61,6 +61,8 @@ namespace Thread
 	class H1WorkerThread_Context
 	{
 	public:
+		// memory stack for temporary allocations of the thread (see H1TempArray)
+		SGD::Memory::H1MemStack& GetMemStack() { return MemStack; }
 
 	protected:
 		H1WorkerThread_Context();